@@ -0,0 +1,569 @@
+/** @file
+ *
+ *  Print the firmware boot timeline recorded in the ACPI FPDT.
+ *
+ *  Start/end records logged by the DXE core (image entry points, driver
+ *  binding Start) and by PERF_INMODULE_BEGIN/END markers are paired into
+ *  measurements, named after the module that logged them.
+ *
+ *  Copyright (c) 2025, Mario Bălănică <mariobalanica02@gmail.com>
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PeCoffGetEntryPointLib.h>
+#include <Library/PerformanceLib.h>
+#include <Library/ShellLib.h>
+#include <Library/SortLib.h>
+#include <Library/UefiApplicationEntryPoint.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <IndustryStandard/Acpi.h>
+#include <Guid/ExtendedFirmwarePerformance.h>
+#include <Protocol/LoadedImage.h>
+
+#define PERF_NAME_LENGTH  FPDT_STRING_EVENT_RECORD_NAME_LENGTH
+
+typedef struct {
+  EFI_GUID    Guid;
+  UINT16      ProgressId;
+  UINT64      Timestamp;
+  UINT64      Qword;
+  CHAR8       String[PERF_NAME_LENGTH];
+  BOOLEAN     Matched;
+} PERF_RECORD;
+
+typedef struct {
+  EFI_GUID    Guid;
+  UINT16      ProgressId;
+  UINT64      Start;
+  UINT64      Duration;
+  CHAR8       Label[PERF_NAME_LENGTH];
+} PERF_MEASUREMENT;
+
+typedef struct {
+  EFI_GUID    Guid;
+  CHAR8       Name[PERF_NAME_LENGTH];
+} PERF_MODULE_NAME;
+
+STATIC CONST SHELL_PARAM_ITEM  mParamList[] = {
+  { L"-t", TypeFlag  },
+  { L"-n", TypeValue },
+  { NULL,  TypeMax   }
+};
+
+STATIC PERF_MODULE_NAME  *mModuleNames;
+STATIC UINTN             mModuleNameCount;
+
+STATIC
+CONST CHAR8 *
+PhaseName (
+  IN UINT16  ProgressId
+  )
+{
+  switch (ProgressId) {
+    case MODULE_START_ID:
+      return "Entry";
+    case MODULE_LOADIMAGE_START_ID:
+      return "LoadImage";
+    case MODULE_DB_START_ID:
+      return "Start";
+    case MODULE_DB_SUPPORT_START_ID:
+      return "Supported";
+    case MODULE_DB_STOP_START_ID:
+      return "Stop";
+    case PERF_EVENTSIGNAL_START_ID:
+      return "EventSignal";
+    case PERF_CALLBACK_START_ID:
+      return "Callback";
+    case PERF_FUNCTION_START_ID:
+      return "Function";
+    default:
+      return "";
+  }
+}
+
+/**
+  Collect the names of all loaded images, keyed by their FV file GUID.
+**/
+STATIC
+VOID
+LoadModuleNames (
+  VOID
+  )
+{
+  EFI_STATUS                 Status;
+  EFI_HANDLE                 *Handles;
+  UINTN                      HandleCount;
+  UINTN                      Index;
+  EFI_LOADED_IMAGE_PROTOCOL  *LoadedImage;
+  EFI_DEVICE_PATH_PROTOCOL   *Node;
+  CONST EFI_GUID             *FileGuid;
+  CHAR8                      *Pdb;
+  UINTN                      Start;
+  UINTN                      End;
+  PERF_MODULE_NAME           *Entry;
+
+  Status = gBS->LocateHandleBuffer (
+                  ByProtocol,
+                  &gEfiLoadedImageProtocolGuid,
+                  NULL,
+                  &HandleCount,
+                  &Handles
+                  );
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  mModuleNames = AllocateZeroPool (HandleCount * sizeof (PERF_MODULE_NAME));
+  if (mModuleNames == NULL) {
+    FreePool (Handles);
+    return;
+  }
+
+  for (Index = 0; Index < HandleCount; Index++) {
+    Status = gBS->HandleProtocol (Handles[Index], &gEfiLoadedImageProtocolGuid, (VOID **)&LoadedImage);
+    if (EFI_ERROR (Status) || (LoadedImage->FilePath == NULL)) {
+      continue;
+    }
+
+    FileGuid = NULL;
+    for (Node = LoadedImage->FilePath; !IsDevicePathEnd (Node); Node = NextDevicePathNode (Node)) {
+      FileGuid = EfiGetNameGuidFromFwVolDevicePathNode ((MEDIA_FW_VOL_FILEPATH_DEVICE_PATH *)Node);
+      if (FileGuid != NULL) {
+        break;
+      }
+    }
+
+    Pdb = PeCoffLoaderGetPdbPointer (LoadedImage->ImageBase);
+    if ((FileGuid == NULL) || (Pdb == NULL)) {
+      continue;
+    }
+
+    //
+    // Reduce ".../FooDxe/DEBUG/FooDxe.dll" to "FooDxe".
+    //
+    Start = 0;
+    for (End = 0; Pdb[End] != '\0'; End++) {
+      if ((Pdb[End] == '/') || (Pdb[End] == '\\')) {
+        Start = End + 1;
+      }
+    }
+
+    for (End = Start; (Pdb[End] != '\0') && (Pdb[End] != '.'); End++) {
+    }
+
+    Entry = &mModuleNames[mModuleNameCount++];
+    CopyGuid (&Entry->Guid, FileGuid);
+    AsciiStrnCpyS (Entry->Name, PERF_NAME_LENGTH, Pdb + Start, MIN (End - Start, PERF_NAME_LENGTH - 1));
+  }
+
+  FreePool (Handles);
+}
+
+STATIC
+CONST CHAR8 *
+GetModuleName (
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < mModuleNameCount; Index++) {
+    if (CompareGuid (&mModuleNames[Index].Guid, Guid)) {
+      return mModuleNames[Index].Name;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Decode the extended records of the FBPT into a flat array.
+**/
+STATIC
+EFI_STATUS
+ReadRecords (
+  IN  EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER    *Fbpt,
+  OUT EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD  **BasicBoot,
+  OUT PERF_RECORD                                   **Records,
+  OUT UINTN                                         *RecordCount
+  )
+{
+  UINT8               *Ptr;
+  UINT8               *End;
+  FPDT_RECORD_HEADER  *Header;
+  PERF_RECORD         *Record;
+  CONST CHAR8         *String;
+  UINTN               StringSize;
+  UINTN               Count;
+
+  *BasicBoot   = NULL;
+  *RecordCount = 0;
+
+  //
+  // Every record is at least a header plus a timestamp, which bounds the count.
+  //
+  *Records = AllocateZeroPool ((Fbpt->Length / (sizeof (FPDT_RECORD_HEADER) + sizeof (UINT64)) + 1) * sizeof (PERF_RECORD));
+  if (*Records == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Count = 0;
+  Ptr   = (UINT8 *)(Fbpt + 1);
+  End   = (UINT8 *)Fbpt + Fbpt->Length;
+
+  while (Ptr + sizeof (FPDT_RECORD_HEADER) <= End) {
+    Header = (FPDT_RECORD_HEADER *)Ptr;
+    if ((Header->Length < sizeof (FPDT_RECORD_HEADER)) || (Ptr + Header->Length > End)) {
+      break;
+    }
+
+    Record     = &(*Records)[Count];
+    String     = NULL;
+    StringSize = 0;
+
+    switch (Header->Type) {
+      case EFI_ACPI_5_0_FPDT_RUNTIME_RECORD_TYPE_FIRMWARE_BASIC_BOOT:
+        *BasicBoot = (EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD *)Header;
+        break;
+
+      case FPDT_GUID_EVENT_TYPE:
+        Record->ProgressId = ((FPDT_GUID_EVENT_RECORD *)Header)->ProgressID;
+        Record->Timestamp  = ((FPDT_GUID_EVENT_RECORD *)Header)->Timestamp;
+        CopyGuid (&Record->Guid, &((FPDT_GUID_EVENT_RECORD *)Header)->Guid);
+        Count++;
+        break;
+
+      case FPDT_DYNAMIC_STRING_EVENT_TYPE:
+        Record->ProgressId = ((FPDT_DYNAMIC_STRING_EVENT_RECORD *)Header)->ProgressID;
+        Record->Timestamp  = ((FPDT_DYNAMIC_STRING_EVENT_RECORD *)Header)->Timestamp;
+        CopyGuid (&Record->Guid, &((FPDT_DYNAMIC_STRING_EVENT_RECORD *)Header)->Guid);
+        String     = (CHAR8 *)Header + sizeof (FPDT_DYNAMIC_STRING_EVENT_RECORD);
+        StringSize = Header->Length - sizeof (FPDT_DYNAMIC_STRING_EVENT_RECORD);
+        Count++;
+        break;
+
+      case FPDT_DUAL_GUID_STRING_EVENT_TYPE:
+        Record->ProgressId = ((FPDT_DUAL_GUID_STRING_EVENT_RECORD *)Header)->ProgressID;
+        Record->Timestamp  = ((FPDT_DUAL_GUID_STRING_EVENT_RECORD *)Header)->Timestamp;
+        CopyGuid (&Record->Guid, &((FPDT_DUAL_GUID_STRING_EVENT_RECORD *)Header)->Guid1);
+        String     = (CHAR8 *)Header + sizeof (FPDT_DUAL_GUID_STRING_EVENT_RECORD);
+        StringSize = Header->Length - sizeof (FPDT_DUAL_GUID_STRING_EVENT_RECORD);
+        Count++;
+        break;
+
+      case FPDT_GUID_QWORD_EVENT_TYPE:
+        Record->ProgressId = ((FPDT_GUID_QWORD_EVENT_RECORD *)Header)->ProgressID;
+        Record->Timestamp  = ((FPDT_GUID_QWORD_EVENT_RECORD *)Header)->Timestamp;
+        Record->Qword      = ((FPDT_GUID_QWORD_EVENT_RECORD *)Header)->Qword;
+        CopyGuid (&Record->Guid, &((FPDT_GUID_QWORD_EVENT_RECORD *)Header)->Guid);
+        Count++;
+        break;
+
+      case FPDT_GUID_QWORD_STRING_EVENT_TYPE:
+        Record->ProgressId = ((FPDT_GUID_QWORD_STRING_EVENT_RECORD *)Header)->ProgressID;
+        Record->Timestamp  = ((FPDT_GUID_QWORD_STRING_EVENT_RECORD *)Header)->Timestamp;
+        Record->Qword      = ((FPDT_GUID_QWORD_STRING_EVENT_RECORD *)Header)->Qword;
+        CopyGuid (&Record->Guid, &((FPDT_GUID_QWORD_STRING_EVENT_RECORD *)Header)->Guid);
+        String     = (CHAR8 *)Header + sizeof (FPDT_GUID_QWORD_STRING_EVENT_RECORD);
+        StringSize = Header->Length - sizeof (FPDT_GUID_QWORD_STRING_EVENT_RECORD);
+        Count++;
+        break;
+
+      default:
+        break;
+    }
+
+    if ((String != NULL) && (StringSize > 0)) {
+      AsciiStrnCpyS (
+        Record->String,
+        PERF_NAME_LENGTH,
+        String,
+        MIN (AsciiStrnLenS (String, StringSize), PERF_NAME_LENGTH - 1)
+        );
+    }
+
+    Ptr += Header->Length;
+  }
+
+  *RecordCount = Count;
+  return EFI_SUCCESS;
+}
+
+/**
+  Return TRUE if ProgressId is the start half of a start/end pair.
+**/
+STATIC
+BOOLEAN
+IsStartId (
+  IN UINT16  ProgressId
+  )
+{
+  switch (ProgressId) {
+    case MODULE_START_ID:
+    case MODULE_LOADIMAGE_START_ID:
+    case MODULE_DB_START_ID:
+    case MODULE_DB_SUPPORT_START_ID:
+    case MODULE_DB_STOP_START_ID:
+    case PERF_EVENTSIGNAL_START_ID:
+    case PERF_CALLBACK_START_ID:
+    case PERF_FUNCTION_START_ID:
+    case PERF_INMODULE_START_ID:
+    case PERF_CROSSMODULE_START_ID:
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+/**
+  Pair every start record with the first following end record of the
+  same module, kind, controller and label. Unpaired end records are
+  never treated as starts.
+**/
+STATIC
+UINTN
+PairRecords (
+  IN  PERF_RECORD       *Records,
+  IN  UINTN             RecordCount,
+  OUT PERF_MEASUREMENT  *Measurements
+  )
+{
+  UINTN             Index;
+  UINTN             Search;
+  UINTN             Count;
+  PERF_RECORD       *Start;
+  PERF_RECORD       *End;
+  PERF_MEASUREMENT  *Measurement;
+
+  Count = 0;
+
+  for (Index = 0; Index < RecordCount; Index++) {
+    Start = &Records[Index];
+    if (Start->Matched || !IsStartId (Start->ProgressId)) {
+      continue;
+    }
+
+    for (Search = Index + 1; Search < RecordCount; Search++) {
+      End = &Records[Search];
+      if (  End->Matched
+         || (End->ProgressId != Start->ProgressId + 1)
+         || !CompareGuid (&End->Guid, &Start->Guid)
+         || (End->Qword != Start->Qword)
+         || ((Start->String[0] != '\0') && (End->String[0] != '\0') &&
+             (AsciiStrCmp (End->String, Start->String) != 0)))
+      {
+        continue;
+      }
+
+      Start->Matched = TRUE;
+      End->Matched   = TRUE;
+
+      Measurement             = &Measurements[Count++];
+      Measurement->ProgressId = Start->ProgressId;
+      Measurement->Start      = Start->Timestamp;
+      Measurement->Duration   = (End->Timestamp >= Start->Timestamp) ? End->Timestamp - Start->Timestamp : 0;
+      CopyGuid (&Measurement->Guid, &Start->Guid);
+      AsciiStrCpyS (
+        Measurement->Label,
+        PERF_NAME_LENGTH,
+        (Start->String[0] != '\0') ? Start->String : PhaseName (Start->ProgressId)
+        );
+      break;
+    }
+  }
+
+  return Count;
+}
+
+STATIC
+INTN
+EFIAPI
+CompareByStart (
+  IN CONST VOID  *Buffer1,
+  IN CONST VOID  *Buffer2
+  )
+{
+  CONST PERF_MEASUREMENT  *A = Buffer1;
+  CONST PERF_MEASUREMENT  *B = Buffer2;
+
+  if (A->Start != B->Start) {
+    return (A->Start < B->Start) ? -1 : 1;
+  }
+
+  return 0;
+}
+
+STATIC
+INTN
+EFIAPI
+CompareByDuration (
+  IN CONST VOID  *Buffer1,
+  IN CONST VOID  *Buffer2
+  )
+{
+  CONST PERF_MEASUREMENT  *A = Buffer1;
+  CONST PERF_MEASUREMENT  *B = Buffer2;
+
+  if (A->Duration != B->Duration) {
+    return (A->Duration > B->Duration) ? -1 : 1;
+  }
+
+  return CompareByStart (Buffer1, Buffer2);
+}
+
+STATIC
+VOID
+Usage (
+  VOID
+  )
+{
+  Print (
+    L"Print the firmware boot timeline.\n\n"
+    L"BootPerf [-t] [-n <Count>]\n\n"
+    L"  -t          sort by duration instead of start time\n"
+    L"  -n <Count>  only print the first Count entries\n"
+    );
+}
+
+EFI_STATUS
+EFIAPI
+UefiMain (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS                                               Status;
+  LIST_ENTRY                                               *Package;
+  CHAR16                                                   *ProblemParam;
+  CONST CHAR16                                             *ValueStr;
+  UINTN                                                    Limit;
+  EFI_ACPI_DESCRIPTION_HEADER                              *Fpdt;
+  EFI_ACPI_5_0_FPDT_BOOT_PERFORMANCE_TABLE_POINTER_RECORD  *Pointer;
+  EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER               *Fbpt;
+  EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD             *BasicBoot;
+  PERF_RECORD                                              *Records;
+  UINTN                                                    RecordCount;
+  PERF_MEASUREMENT                                         *Measurements;
+  UINTN                                                    Count;
+  UINTN                                                    Index;
+  CONST CHAR8                                              *Name;
+
+  Status = ShellCommandLineParse (mParamList, &Package, &ProblemParam, TRUE);
+  if (EFI_ERROR (Status)) {
+    if (ProblemParam != NULL) {
+      Print (L"BootPerf: Unknown parameter '%s'\n", ProblemParam);
+      FreePool (ProblemParam);
+    }
+
+    Usage ();
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Limit    = MAX_UINTN;
+  ValueStr = ShellCommandLineGetValue (Package, L"-n");
+  if (ValueStr != NULL) {
+    Limit = ShellStrToUintn (ValueStr);
+  }
+
+  Fpdt = (EFI_ACPI_DESCRIPTION_HEADER *)EfiLocateFirstAcpiTable (
+                                          EFI_ACPI_5_0_FIRMWARE_PERFORMANCE_DATA_TABLE_SIGNATURE
+                                          );
+  if (Fpdt == NULL) {
+    Print (L"BootPerf: No FPDT found. Is performance measurement enabled in this build?\n");
+    Status = EFI_NOT_FOUND;
+    goto Exit;
+  }
+
+  Fbpt = NULL;
+  for (Pointer = (VOID *)(Fpdt + 1);
+       (UINT8 *)Pointer + sizeof (*Pointer) <= (UINT8 *)Fpdt + Fpdt->Length;
+       Pointer = (VOID *)((UINT8 *)Pointer + Pointer->Header.Length))
+  {
+    if (Pointer->Header.Length == 0) {
+      break;
+    }
+
+    if (Pointer->Header.Type == EFI_ACPI_5_0_FPDT_RECORD_TYPE_FIRMWARE_BASIC_BOOT_POINTER) {
+      Fbpt = (VOID *)(UINTN)Pointer->BootPerformanceTablePointer;
+      break;
+    }
+  }
+
+  if ((Fbpt == NULL) || (Fbpt->Signature != EFI_ACPI_5_0_FPDT_BOOT_PERFORMANCE_TABLE_SIGNATURE)) {
+    Print (L"BootPerf: No boot performance table found.\n");
+    Status = EFI_NOT_FOUND;
+    goto Exit;
+  }
+
+  Status = ReadRecords (Fbpt, &BasicBoot, &Records, &RecordCount);
+  if (EFI_ERROR (Status)) {
+    goto Exit;
+  }
+
+  Measurements = AllocateZeroPool ((RecordCount + 1) * sizeof (PERF_MEASUREMENT));
+  if (Measurements == NULL) {
+    FreePool (Records);
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+
+  Count = PairRecords (Records, RecordCount, Measurements);
+  PerformQuickSort (
+    Measurements,
+    Count,
+    sizeof (PERF_MEASUREMENT),
+    ShellCommandLineGetFlag (Package, L"-t") ? CompareByDuration : CompareByStart
+    );
+
+  LoadModuleNames ();
+
+  if (BasicBoot != NULL) {
+    Print (L"Reset end:        %8Lu us\n", DivU64x32 (BasicBoot->ResetEnd, 1000));
+  }
+
+  Print (L"%u measurements from %u records\n\n", (UINT32)Count, (UINT32)RecordCount);
+  Print (L"   Start(ms)  Duration(ms)  Module                    Measurement\n");
+  Print (L"  ----------  ------------  ------------------------  ------------------------\n");
+
+  for (Index = 0; Index < Count && Index < Limit; Index++) {
+    Name = GetModuleName (&Measurements[Index].Guid);
+    if (Name != NULL) {
+      Print (
+        L"  %10Lu  %8Lu.%03Lu  %-24a  %a\n",
+        DivU64x32 (Measurements[Index].Start, 1000000),
+        DivU64x32 (Measurements[Index].Duration, 1000000),
+        ModU64x32 (DivU64x32 (Measurements[Index].Duration, 1000), 1000),
+        Name,
+        Measurements[Index].Label
+        );
+    } else {
+      Print (
+        L"  %10Lu  %8Lu.%03Lu  %g  %a\n",
+        DivU64x32 (Measurements[Index].Start, 1000000),
+        DivU64x32 (Measurements[Index].Duration, 1000000),
+        ModU64x32 (DivU64x32 (Measurements[Index].Duration, 1000), 1000),
+        &Measurements[Index].Guid,
+        Measurements[Index].Label
+        );
+    }
+  }
+
+  if (mModuleNames != NULL) {
+    FreePool (mModuleNames);
+  }
+
+  FreePool (Measurements);
+  FreePool (Records);
+
+Exit:
+  ShellCommandLineFreeVarList (Package);
+  return Status;
+}
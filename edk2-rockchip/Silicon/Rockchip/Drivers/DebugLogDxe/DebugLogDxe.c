@@ -0,0 +1,183 @@
+/** @file
+ *
+ *  DXE debug log buffer
+ *
+ *  Publishes an in-memory ring that BufferedDw8250SerialPortLib writes
+ *  debug output into, and sends its contents to the serial port from a
+ *  timer event. The ring is installed as a configuration table so the
+ *  boot log can also be retrieved later by the OS or a shell command.
+ *
+ *  This driver itself must be built with a SerialPortLib that writes to
+ *  the UART directly.
+ *
+ *  Copyright (c) 2025, Mario Bălănică <mariobalanica02@gmail.com>
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
+#include <Library/SerialPortLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Guid/DebugLogTable.h>
+
+//
+// Each tick only refills an empty TX FIFO, so that the timer never waits
+// on the UART. The period matches the timer interrupt (PcdTimerPeriod).
+//
+#define DEBUG_LOG_DRAIN_PERIOD  EFI_TIMER_PERIOD_MILLISECONDS (1)
+#define DEBUG_LOG_DRAIN_CHUNK   64 // TX FIFO depth
+
+STATIC ROCKCHIP_DEBUG_LOG_TABLE  *mDebugLog;
+STATIC EFI_EVENT                 mDrainEvent;
+STATIC EFI_EVENT                 mExitBootServicesEvent;
+
+/**
+  Send up to MaxBytes of the logged data to the serial port.
+  Must be called at TPL_NOTIFY.
+**/
+STATIC
+VOID
+DebugLogSend (
+  IN UINT64  MaxBytes
+  )
+{
+  UINT8   *Data;
+  UINT64  Limit;
+  UINTN   Offset;
+  UINTN   Length;
+
+  Data  = (UINT8 *)(mDebugLog + 1);
+  Limit = mDebugLog->Tail + MIN (mDebugLog->Head - mDebugLog->Tail, MaxBytes);
+
+  mDebugLog->Busy = 1;
+
+  while (mDebugLog->Tail < Limit) {
+    Offset = ModU64x32 (mDebugLog->Tail, mDebugLog->Size);
+    Length = (UINTN)MIN (Limit - mDebugLog->Tail, mDebugLog->Size - Offset);
+    SerialPortWrite (Data + Offset, Length);
+    mDebugLog->Tail += Length;
+  }
+
+  mDebugLog->Busy = 0;
+}
+
+STATIC
+VOID
+EFIAPI
+DebugLogDrainEvent (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  UINT32  Control;
+
+  if (mDebugLog->Tail == mDebugLog->Head) {
+    return;
+  }
+
+  if (EFI_ERROR (SerialPortGetControl (&Control)) ||
+      ((Control & EFI_SERIAL_OUTPUT_BUFFER_EMPTY) == 0))
+  {
+    return;
+  }
+
+  DebugLogSend (DEBUG_LOG_DRAIN_CHUNK);
+}
+
+STATIC
+VOID
+EFIAPI
+DebugLogExitBootServicesEvent (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  gBS->SetTimer (mDrainEvent, TimerCancel, 0);
+  DebugLogSend (MAX_UINT64);
+
+  //
+  // The timer no longer runs, so remaining output must be synchronous.
+  // The log itself stays in runtime memory for the OS.
+  //
+  mDebugLog->Active = 0;
+}
+
+EFI_STATUS
+EFIAPI
+DebugLogDxeInitialize (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Size;
+
+  Size = FixedPcdGet32 (PcdDebugLogBufferSize);
+  if (Size == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  mDebugLog = AllocateRuntimePages (EFI_SIZE_TO_PAGES (sizeof (ROCKCHIP_DEBUG_LOG_TABLE) + Size));
+  if (mDebugLog == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mDebugLog->Signature = ROCKCHIP_DEBUG_LOG_TABLE_SIGNATURE;
+  mDebugLog->Size      = Size;
+  mDebugLog->Head      = 0;
+  mDebugLog->Tail      = 0;
+  mDebugLog->Active    = 0;
+  mDebugLog->Busy      = 0;
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  DebugLogDrainEvent,
+                  NULL,
+                  &mDrainEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    goto ErrorFreeLog;
+  }
+
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  DebugLogExitBootServicesEvent,
+                  NULL,
+                  &gEfiEventExitBootServicesGuid,
+                  &mExitBootServicesEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    goto ErrorCloseTimer;
+  }
+
+  Status = gBS->SetTimer (mDrainEvent, TimerPeriodic, DEBUG_LOG_DRAIN_PERIOD);
+  if (EFI_ERROR (Status)) {
+    goto ErrorCloseExitBootServices;
+  }
+
+  Status = gBS->InstallConfigurationTable (&gRockchipDebugLogTableGuid, mDebugLog);
+  if (EFI_ERROR (Status)) {
+    goto ErrorCloseExitBootServices;
+  }
+
+  mDebugLog->Active = 1;
+
+  DEBUG ((DEBUG_INFO, "DebugLogDxe: %u KB debug log at 0x%p\n", Size / SIZE_1KB, mDebugLog));
+
+  return EFI_SUCCESS;
+
+ErrorCloseExitBootServices:
+  gBS->CloseEvent (mExitBootServicesEvent);
+ErrorCloseTimer:
+  gBS->CloseEvent (mDrainEvent);
+ErrorFreeLog:
+  FreePages (mDebugLog, EFI_SIZE_TO_PAGES (sizeof (ROCKCHIP_DEBUG_LOG_TABLE) + Size));
+  mDebugLog = NULL;
+  return Status;
+}
@@ -64,8 +64,12 @@ EmmcSdMmcCapability (
   // Disable ADMA2 to avoid data corruption.
   // This controller has the limitation that a single descriptor
   // cannot cross 128 MB boundaries and must be split.
-  // This would require a patch in SdMmcPciHcDxe, but SDMA works
-  // fine for the time being.
+  // SdMmcPciHcDxe only splits descriptors at the maximum line length
+  // (64 KB, or 64 MB in 26-bit mode), so even a 64 KB line that starts
+  // below a 128 MB boundary and ends above it would corrupt data.
+  // Neither this override protocol nor the non-discoverable device
+  // layer can influence descriptor generation, so this would require
+  // a patch in SdMmcPciHcDxe. SDMA works fine for the time being.
   //
   Capability->Adma2 = 0;
 
@@ -10,6 +10,92 @@
 
 #include "LcdGraphicsOutputDxe.h"
 
+//
+// Granularity of the writes from the shadow copy to the framebuffer,
+// one cache line.
+//
+#define LCD_FLUSH_ALIGNMENT  64
+
+/**
+  Return the buffer Blt operations draw into: the shadow copy of the
+  framebuffer if there is one, the framebuffer itself otherwise.
+
+**/
+STATIC
+UINT32 *
+LcdGraphicsGetBltTarget (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL  *This
+  )
+{
+  LCD_INSTANCE  *Instance;
+
+  Instance = LCD_INSTANCE_FROM_GOP_THIS (This);
+  if (Instance->ShadowFrameBuffer != NULL) {
+    return Instance->ShadowFrameBuffer;
+  }
+
+  return (UINT32 *)(UINTN)This->Mode->FrameBufferBase;
+}
+
+/**
+  Write a rectangle of the shadow copy through to the framebuffer.
+
+  Each row is widened to whole cache lines, so the write-combined
+  framebuffer only sees full-line bursts. This is safe because the
+  shadow copy only exists in PixelBltOnly modes, where nothing but
+  Blt() writes to the framebuffer. A rectangle spanning whole rows is
+  written as a single run.
+
+  @param[in] This           The GOP instance.
+  @param[in] X              Left edge of the rectangle, in framebuffer pixels.
+  @param[in] Y              Top edge of the rectangle, in framebuffer pixels.
+  @param[in] Width          Width of the rectangle.
+  @param[in] Height         Height of the rectangle.
+  @param[in] Stride         Pixels per framebuffer row.
+
+**/
+STATIC
+VOID
+LcdGraphicsFlushRect (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL  *This,
+  IN UINTN                         X,
+  IN UINTN                         Y,
+  IN UINTN                         Width,
+  IN UINTN                         Height,
+  IN UINTN                         Stride
+  )
+{
+  LCD_INSTANCE  *Instance;
+  UINT8         *FrameBuffer;
+  UINT8         *Shadow;
+  UINTN         Start;
+  UINTN         End;
+  UINTN         Row;
+
+  Instance = LCD_INSTANCE_FROM_GOP_THIS (This);
+  if (Instance->ShadowFrameBuffer == NULL) {
+    return;
+  }
+
+  FrameBuffer = (UINT8 *)(UINTN)This->Mode->FrameBufferBase;
+  Shadow      = (UINT8 *)Instance->ShadowFrameBuffer;
+
+  if (Width == Stride) {
+    Width *= Height;
+    Height = 1;
+  }
+
+  for (Row = 0; Row < Height; Row++) {
+    Start = ((Y + Row) * Stride + X) * RK_BYTES_PER_PIXEL;
+    End   = Start + Width * RK_BYTES_PER_PIXEL;
+
+    Start &= ~(UINTN)(LCD_FLUSH_ALIGNMENT - 1);
+    End    = MIN (ALIGN_VALUE (End, LCD_FLUSH_ALIGNMENT), This->Mode->FrameBufferSize);
+
+    CopyMem (FrameBuffer + Start, Shadow + Start, End - Start);
+  }
+}
+
 STATIC
 EFI_STATUS
 LcdGraphicsBltCheckParameters (
@@ -96,7 +182,7 @@ LcdGraphicsBlt (
   UINT32      *DestinationBuffer;
   UINTN       Y;
 
-  FrameBuffer          = (UINT32 *)This->Mode->FrameBufferBase;
+  FrameBuffer          = LcdGraphicsGetBltTarget (This);
   HorizontalResolution = This->Mode->Info->HorizontalResolution;
   WidthInBytes         = Width * RK_BYTES_PER_PIXEL;
 
@@ -201,12 +287,102 @@ LcdGraphicsBlt (
       return EFI_INVALID_PARAMETER;
   }
 
+  if (BltOperation != EfiBltVideoToBltBuffer) {
+    LcdGraphicsFlushRect (This, DestinationX, DestinationY, Width, Height, HorizontalResolution);
+  }
+
   return EFI_SUCCESS;
 }
 
+//
+// Rotated transfers go through square tiles so that both the reads and the
+// (write-combined) framebuffer writes are sequential runs of pixels.
+// 16 pixels of 32 bits fill a 64-byte cache line.
+//
+#define LCD_BLT_TILE_SIZE  16
+
+/**
+  Copy a rectangle between two surfaces with arbitrary orientation.
+
+  Each surface is described by the address of the rectangle's top-left
+  pixel and the distance, in pixels, between horizontally and vertically
+  adjacent pixels. One of the two steps of each surface must be +/-1.
+
+**/
+STATIC
+VOID
+LcdGraphicsCopyTiled (
+  OUT UINT32        *Destination,
+  IN  INTN          DestinationStepX,
+  IN  INTN          DestinationStepY,
+  IN  CONST UINT32  *Source,
+  IN  INTN          SourceStepX,
+  IN  INTN          SourceStepY,
+  IN  UINTN         Width,
+  IN  UINTN         Height
+  )
+{
+  UINT32        Tile[LCD_BLT_TILE_SIZE][LCD_BLT_TILE_SIZE];
+  UINTN         TileX;
+  UINTN         TileY;
+  UINTN         TileWidth;
+  UINTN         TileHeight;
+  CONST UINT32  *Src;
+  UINT32        *Dst;
+  UINTN         X;
+  UINTN         Y;
+
+  for (TileY = 0; TileY < Height; TileY += LCD_BLT_TILE_SIZE) {
+    TileHeight = MIN (LCD_BLT_TILE_SIZE, Height - TileY);
+
+    for (TileX = 0; TileX < Width; TileX += LCD_BLT_TILE_SIZE) {
+      TileWidth = MIN (LCD_BLT_TILE_SIZE, Width - TileX);
+
+      Src = Source + (INTN)TileX * SourceStepX + (INTN)TileY * SourceStepY;
+      Dst = Destination + (INTN)TileX * DestinationStepX + (INTN)TileY * DestinationStepY;
+
+      if (ABS (SourceStepX) == 1) {
+        for (Y = 0; Y < TileHeight; Y++) {
+          for (X = 0; X < TileWidth; X++) {
+            Tile[Y][X] = Src[(INTN)X * SourceStepX + (INTN)Y * SourceStepY];
+          }
+        }
+      } else {
+        for (X = 0; X < TileWidth; X++) {
+          for (Y = 0; Y < TileHeight; Y++) {
+            Tile[Y][X] = Src[(INTN)X * SourceStepX + (INTN)Y * SourceStepY];
+          }
+        }
+      }
+
+      if (ABS (DestinationStepX) == 1) {
+        for (Y = 0; Y < TileHeight; Y++) {
+          for (X = 0; X < TileWidth; X++) {
+            Dst[(INTN)X * DestinationStepX + (INTN)Y * DestinationStepY] = Tile[Y][X];
+          }
+        }
+      } else {
+        for (X = 0; X < TileWidth; X++) {
+          for (Y = 0; Y < TileHeight; Y++) {
+            Dst[(INTN)X * DestinationStepX + (INTN)Y * DestinationStepY] = Tile[Y][X];
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+  Rotated Blt for a framebuffer scanned out at Rotation degrees clockwise.
+
+  This->Mode->Info describes the rotated (logical) screen. Fills and
+  video-to-video copies map to plain rectangles of the framebuffer, while
+  transfers to or from BltBuffer have to be reoriented.
+
+**/
+STATIC
 EFI_STATUS
-EFIAPI
-LcdGraphicsBlt90 (
+LcdGraphicsBltRotated (
   IN EFI_GRAPHICS_OUTPUT_PROTOCOL       *This,
   IN OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *BltBuffer  OPTIONAL,
   IN EFI_GRAPHICS_OUTPUT_BLT_OPERATION  BltOperation,
@@ -216,21 +392,33 @@ LcdGraphicsBlt90 (
   IN UINTN                              DestinationY,
   IN UINTN                              Width,
   IN UINTN                              Height,
-  IN UINTN                              Delta       OPTIONAL
+  IN UINTN                              Delta       OPTIONAL,
+  IN UINT16                             Rotation
   )
 {
   EFI_STATUS  Status;
   UINT32      *FrameBuffer;
-  UINT32      HorizontalResolution;
+  UINT32      LogicalWidth;
+  UINT32      LogicalHeight;
+  UINT32      Stride;
   UINTN       WidthInBytes;
+  UINT32      *Origin;
+  INTN        StepX;
+  INTN        StepY;
+  UINTN       PhysSourceX;
+  UINTN       PhysSourceY;
+  UINTN       PhysDestinationX;
+  UINTN       PhysDestinationY;
+  UINTN       PhysWidth;
+  UINTN       PhysHeight;
   UINT32      *SourceBuffer;
   UINT32      *DestinationBuffer;
   UINTN       Y;
-  UINTN       X;
 
-  FrameBuffer          = (UINT32 *)This->Mode->FrameBufferBase;
-  HorizontalResolution = This->Mode->Info->VerticalResolution;
-  WidthInBytes         = Width * RK_BYTES_PER_PIXEL;
+  FrameBuffer   = LcdGraphicsGetBltTarget (This);
+  LogicalWidth  = This->Mode->Info->HorizontalResolution;
+  LogicalHeight = This->Mode->Info->VerticalResolution;
+  WidthInBytes  = Width * RK_BYTES_PER_PIXEL;
 
   Status = LcdGraphicsBltCheckParameters (
              This,
@@ -248,18 +436,72 @@ LcdGraphicsBlt90 (
     return Status;
   }
 
+  //
+  // Logical (X, Y) is at Origin + X * StepX + Y * StepY in the framebuffer.
+  //
+  switch (Rotation) {
+    case 90:
+      Stride = LogicalHeight;
+      Origin = FrameBuffer + (LogicalHeight - 1);
+      StepX  = Stride;
+      StepY  = -1;
+      break;
+
+    case 180:
+      Stride = LogicalWidth;
+      Origin = FrameBuffer + (LogicalHeight - 1) * Stride + (LogicalWidth - 1);
+      StepX  = -1;
+      StepY  = -(INTN)Stride;
+      break;
+
+    case 270:
+      Stride = LogicalHeight;
+      Origin = FrameBuffer + (LogicalWidth - 1) * Stride;
+      StepX  = -(INTN)Stride;
+      StepY  = 1;
+      break;
+
+    default:
+      ASSERT (FALSE);
+      return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Bounding rectangles in the framebuffer.
+  //
+  if (Rotation == 180) {
+    PhysSourceX      = LogicalWidth - (SourceX + Width);
+    PhysSourceY      = LogicalHeight - (SourceY + Height);
+    PhysDestinationX = LogicalWidth - (DestinationX + Width);
+    PhysDestinationY = LogicalHeight - (DestinationY + Height);
+    PhysWidth        = Width;
+    PhysHeight       = Height;
+  } else if (Rotation == 90) {
+    PhysSourceX      = LogicalHeight - (SourceY + Height);
+    PhysSourceY      = SourceX;
+    PhysDestinationX = LogicalHeight - (DestinationY + Height);
+    PhysDestinationY = DestinationX;
+    PhysWidth        = Height;
+    PhysHeight       = Width;
+  } else {
+    PhysSourceX      = SourceY;
+    PhysSourceY      = LogicalWidth - (SourceX + Width);
+    PhysDestinationX = DestinationY;
+    PhysDestinationY = LogicalWidth - (DestinationX + Width);
+    PhysWidth        = Height;
+    PhysHeight       = Width;
+  }
+
   switch (BltOperation) {
     case EfiBltVideoFill:
       SourceBuffer = (UINT32 *)BltBuffer;
 
-      for (Y = 0; Y < Height; Y++) {
-        for (X = 0; X < Width; X++) {
-          DestinationBuffer = FrameBuffer +
-                              (HorizontalResolution - 1 - (DestinationY + Y)) +
-                              (DestinationX + X) * HorizontalResolution;
+      for (Y = 0; Y < PhysHeight; Y++) {
+        DestinationBuffer = FrameBuffer +
+                            (PhysDestinationY + Y) * Stride +
+                            PhysDestinationX;
 
-          *DestinationBuffer = *SourceBuffer;
-        }
+        SetMem32 (DestinationBuffer, PhysWidth * RK_BYTES_PER_PIXEL, *SourceBuffer);
       }
 
       break;
@@ -269,20 +511,18 @@ LcdGraphicsBlt90 (
         Delta = WidthInBytes;
       }
 
-      for (Y = 0; Y < Height; Y++) {
-        for (X = 0; X < Width; X++) {
-          SourceBuffer = FrameBuffer +
-                         (HorizontalResolution - 1 - (SourceY + Y)) +
-                         (SourceX + X) * HorizontalResolution;
-
-          DestinationBuffer = (UINT32 *)((UINTN)BltBuffer +
-                                         (DestinationY + Y) * Delta +
-                                         (DestinationX + X) * RK_BYTES_PER_PIXEL);
-
-          *DestinationBuffer = *SourceBuffer;
-        }
-      }
-
+      LcdGraphicsCopyTiled (
+        (UINT32 *)((UINTN)BltBuffer +
+                   DestinationY * Delta +
+                   DestinationX * RK_BYTES_PER_PIXEL),
+        1,
+        Delta / RK_BYTES_PER_PIXEL,
+        Origin + (INTN)SourceX * StepX + (INTN)SourceY * StepY,
+        StepX,
+        StepY,
+        Width,
+        Height
+        );
       break;
 
     case EfiBltBufferToVideo:
@@ -290,50 +530,48 @@ LcdGraphicsBlt90 (
         Delta = WidthInBytes;
       }
 
-      for (Y = 0; Y < Height; Y++) {
-        for (X = 0; X < Width; X++) {
-          SourceBuffer = (UINT32 *)((UINTN)BltBuffer +
-                                    (SourceY + Y) * Delta +
-                                    (SourceX + X) * RK_BYTES_PER_PIXEL);
-
-          DestinationBuffer = FrameBuffer +
-                              (HorizontalResolution - 1 - (DestinationY + Y)) +
-                              (DestinationX + X) * HorizontalResolution;
-
-          *DestinationBuffer = *SourceBuffer;
-        }
-      }
-
+      LcdGraphicsCopyTiled (
+        Origin + (INTN)DestinationX * StepX + (INTN)DestinationY * StepY,
+        StepX,
+        StepY,
+        (UINT32 *)((UINTN)BltBuffer +
+                   SourceY * Delta +
+                   SourceX * RK_BYTES_PER_PIXEL),
+        1,
+        Delta / RK_BYTES_PER_PIXEL,
+        Width,
+        Height
+        );
       break;
 
     case EfiBltVideoToVideo:
-      if (SourceY < DestinationY) {
-        for (Y = Height; Y-- > 0;) {
-          for (X = 0; X < Width; X++) {
-            SourceBuffer = FrameBuffer +
-                           (HorizontalResolution - 1 - (SourceY + Y)) +
-                           (SourceX + X) * HorizontalResolution;
+      //
+      // A move on the rotated screen is the same move of the bounding
+      // rectangle in the framebuffer, so copy whole rows.
+      //
+      if (PhysSourceY < PhysDestinationY) {
+        for (Y = PhysHeight; Y-- > 0;) {
+          SourceBuffer = FrameBuffer +
+                         (PhysSourceY + Y) * Stride +
+                         PhysSourceX;
 
-            DestinationBuffer = FrameBuffer +
-                                (HorizontalResolution - 1 - (DestinationY + Y)) +
-                                (DestinationX + X) * HorizontalResolution;
+          DestinationBuffer = FrameBuffer +
+                              (PhysDestinationY + Y) * Stride +
+                              PhysDestinationX;
 
-            *DestinationBuffer = *SourceBuffer;
-          }
+          CopyMem (DestinationBuffer, SourceBuffer, PhysWidth * RK_BYTES_PER_PIXEL);
         }
       } else {
-        for (Y = 0; Y < Height; Y++) {
-          for (X = 0; X < Width; X++) {
-            SourceBuffer = FrameBuffer +
-                           (HorizontalResolution - 1 - (SourceY + Y)) +
-                           (SourceX + X) * HorizontalResolution;
+        for (Y = 0; Y < PhysHeight; Y++) {
+          SourceBuffer = FrameBuffer +
+                         (PhysSourceY + Y) * Stride +
+                         PhysSourceX;
 
-            DestinationBuffer = FrameBuffer +
-                                (HorizontalResolution - 1 - (DestinationY + Y)) +
-                                (DestinationX + X) * HorizontalResolution;
+          DestinationBuffer = FrameBuffer +
+                              (PhysDestinationY + Y) * Stride +
+                              PhysDestinationX;
 
-            *DestinationBuffer = *SourceBuffer;
-          }
+          CopyMem (DestinationBuffer, SourceBuffer, PhysWidth * RK_BYTES_PER_PIXEL);
         }
       }
 
@@ -343,5 +581,99 @@ LcdGraphicsBlt90 (
       return EFI_INVALID_PARAMETER;
   }
 
+  if (BltOperation != EfiBltVideoToBltBuffer) {
+    LcdGraphicsFlushRect (This, PhysDestinationX, PhysDestinationY, PhysWidth, PhysHeight, Stride);
+  }
+
   return EFI_SUCCESS;
 }
+
+EFI_STATUS
+EFIAPI
+LcdGraphicsBlt90 (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL       *This,
+  IN OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *BltBuffer  OPTIONAL,
+  IN EFI_GRAPHICS_OUTPUT_BLT_OPERATION  BltOperation,
+  IN UINTN                              SourceX,
+  IN UINTN                              SourceY,
+  IN UINTN                              DestinationX,
+  IN UINTN                              DestinationY,
+  IN UINTN                              Width,
+  IN UINTN                              Height,
+  IN UINTN                              Delta       OPTIONAL
+  )
+{
+  return LcdGraphicsBltRotated (
+           This,
+           BltBuffer,
+           BltOperation,
+           SourceX,
+           SourceY,
+           DestinationX,
+           DestinationY,
+           Width,
+           Height,
+           Delta,
+           90
+           );
+}
+
+EFI_STATUS
+EFIAPI
+LcdGraphicsBlt180 (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL       *This,
+  IN OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *BltBuffer  OPTIONAL,
+  IN EFI_GRAPHICS_OUTPUT_BLT_OPERATION  BltOperation,
+  IN UINTN                              SourceX,
+  IN UINTN                              SourceY,
+  IN UINTN                              DestinationX,
+  IN UINTN                              DestinationY,
+  IN UINTN                              Width,
+  IN UINTN                              Height,
+  IN UINTN                              Delta       OPTIONAL
+  )
+{
+  return LcdGraphicsBltRotated (
+           This,
+           BltBuffer,
+           BltOperation,
+           SourceX,
+           SourceY,
+           DestinationX,
+           DestinationY,
+           Width,
+           Height,
+           Delta,
+           180
+           );
+}
+
+EFI_STATUS
+EFIAPI
+LcdGraphicsBlt270 (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL       *This,
+  IN OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *BltBuffer  OPTIONAL,
+  IN EFI_GRAPHICS_OUTPUT_BLT_OPERATION  BltOperation,
+  IN UINTN                              SourceX,
+  IN UINTN                              SourceY,
+  IN UINTN                              DestinationX,
+  IN UINTN                              DestinationY,
+  IN UINTN                              Width,
+  IN UINTN                              Height,
+  IN UINTN                              Delta       OPTIONAL
+  )
+{
+  return LcdGraphicsBltRotated (
+           This,
+           BltBuffer,
+           BltOperation,
+           SourceX,
+           SourceY,
+           DestinationX,
+           DestinationY,
+           Width,
+           Height,
+           Delta,
+           270
+           );
+}
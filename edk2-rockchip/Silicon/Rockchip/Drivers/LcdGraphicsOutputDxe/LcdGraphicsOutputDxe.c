@@ -15,6 +15,7 @@
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/PerformanceLib.h>
 #include <Library/DrmModes.h>
 #include <Library/MediaBusFormat.h>
 
@@ -74,6 +75,8 @@ STATIC LCD_INSTANCE  mLcdTemplate = {
   { 0 },                                       // DisplayStates
   0,                                           // DisplayStatesCount
   NULL,                                        // DisplayModes
+  NULL,                                        // ShadowFrameBuffer
+  0,                                           // ShadowFrameBufferPages
 };
 
 STATIC
@@ -589,7 +592,9 @@ LcdGraphicsOutputInit (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  PERF_INMODULE_BEGIN ("PrepareDisplays");
   Status = PrepareDisplays (Instance);
+  PERF_INMODULE_END ("PrepareDisplays");
   if (EFI_ERROR (Status)) {
     goto Exit;
   }
@@ -599,12 +604,14 @@ LcdGraphicsOutputInit (
 
   PrimaryDisplayState = NULL;
 
+  PERF_INMODULE_BEGIN ("DetectDisplays");
   Status = DetectDisplays (
              Instance,
              ForceOutput,
              DuplicateOutput,
              &PrimaryDisplayState
              );
+  PERF_INMODULE_END ("DetectDisplays");
   if (EFI_ERROR (Status)) {
     goto Exit;
   }
@@ -727,13 +734,17 @@ LcdGraphicsSetModeInfo (
 
   This->Mode->Info->Version = 0;
 
-  if ((Rotation == 90)) {
+  if ((Rotation == 90) || (Rotation == 270)) {
     //
     // Swap the reported resolution and only allow Blt operations.
     //
     Info->HorizontalResolution = DisplayMode->VActive;
     Info->VerticalResolution   = DisplayMode->HActive;
     Info->PixelFormat          = PixelBltOnly;
+  } else if (Rotation == 180) {
+    Info->HorizontalResolution = DisplayMode->HActive;
+    Info->VerticalResolution   = DisplayMode->VActive;
+    Info->PixelFormat          = PixelBltOnly;
   } else {
     Info->HorizontalResolution = DisplayMode->HActive;
     Info->VerticalResolution   = DisplayMode->VActive;
@@ -748,6 +759,14 @@ LcdGraphicsSetModeInfo (
         This->Blt = LcdGraphicsBlt90;
         break;
 
+      case 180:
+        This->Blt = LcdGraphicsBlt180;
+        break;
+
+      case 270:
+        This->Blt = LcdGraphicsBlt270;
+        break;
+
       default:
         This->Blt = LcdGraphicsBlt;
 
@@ -814,6 +833,7 @@ LcdGraphicsSetMode (
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL  FillColour;
   LCD_INSTANCE                   *Instance;
   EFI_PHYSICAL_ADDRESS           VramBaseAddress;
+  EFI_PHYSICAL_ADDRESS           ShadowBaseAddress;
   UINTN                          VramSize;
   UINTN                          NumVramPages;
   UINTN                          NumPreviousVramPages;
@@ -859,6 +879,11 @@ LcdGraphicsSetMode (
       This->Mode->FrameBufferSize = 0;
     }
 
+    if (Instance->ShadowFrameBuffer != NULL) {
+      gBS->FreePages ((UINTN)Instance->ShadowFrameBuffer, Instance->ShadowFrameBufferPages);
+      Instance->ShadowFrameBuffer = NULL;
+    }
+
     VramBaseAddress = SIZE_4GB - 1; // VOP2 only supports 32-bit addresses
     Status          = gBS->AllocatePages (
                              AllocateMaxAddress,
@@ -900,6 +925,40 @@ LcdGraphicsSetMode (
 
   LcdGraphicsSetModeInfo (This, This->Mode->Info, Mode, TRUE);
 
+  //
+  // Reading back from write-combined memory is very slow, so Blt()
+  // works on a cacheable copy and only writes the changes through.
+  // Without it, Blt() falls back to using the framebuffer directly.
+  // The copy is only kept when the framebuffer is not exposed, as
+  // direct writes by the caller would make it stale. In the unrotated
+  // mode, VideoToVideo and VideoToBltBuffer (e.g. console scrolling)
+  // therefore still read from the write-combined framebuffer.
+  //
+  if (This->Mode->Info->PixelFormat != PixelBltOnly) {
+    if (Instance->ShadowFrameBuffer != NULL) {
+      gBS->FreePages ((UINTN)Instance->ShadowFrameBuffer, Instance->ShadowFrameBufferPages);
+      Instance->ShadowFrameBuffer = NULL;
+    }
+  } else if (Instance->ShadowFrameBuffer == NULL) {
+    Status = gBS->AllocatePages (
+                    AllocateAnyPages,
+                    EfiBootServicesData,
+                    NumVramPages,
+                    &ShadowBaseAddress
+                    );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((
+        DEBUG_WARN,
+        "%a: Could not allocate shadow framebuffer: %r\n",
+        __func__,
+        Status
+        ));
+    } else {
+      Instance->ShadowFrameBuffer      = (UINT32 *)(UINTN)ShadowBaseAddress;
+      Instance->ShadowFrameBufferPages = NumVramPages;
+    }
+  }
+
   Instance->Mode.SizeOfInfo = sizeof (EFI_GRAPHICS_OUTPUT_MODE_INFORMATION);
 
   This->Mode->FrameBufferBase = VramBaseAddress;
@@ -45,6 +45,11 @@ typedef struct {
   DISPLAY_STATE                           *DisplayStates[VOP_OUTPUT_IF_NUMS];
   UINT32                                  DisplayStatesCount;
   DISPLAY_MODE                            *DisplayModes;
+  //
+  // Cacheable copy of the framebuffer that Blt() draws into.
+  //
+  UINT32                                  *ShadowFrameBuffer;
+  UINTN                                   ShadowFrameBufferPages;
 } LCD_INSTANCE;
 
 #define LCD_INSTANCE_SIGNATURE  SIGNATURE_32('l', 'c', 'd', '0')
@@ -97,6 +102,36 @@ LcdGraphicsBlt90 (
   IN UINTN                              Delta       OPTIONAL
   );
 
+EFI_STATUS
+EFIAPI
+LcdGraphicsBlt180 (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL       *This,
+  IN OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *BltBuffer  OPTIONAL,
+  IN EFI_GRAPHICS_OUTPUT_BLT_OPERATION  BltOperation,
+  IN UINTN                              SourceX,
+  IN UINTN                              SourceY,
+  IN UINTN                              DestinationX,
+  IN UINTN                              DestinationY,
+  IN UINTN                              Width,
+  IN UINTN                              Height,
+  IN UINTN                              Delta       OPTIONAL
+  );
+
+EFI_STATUS
+EFIAPI
+LcdGraphicsBlt270 (
+  IN EFI_GRAPHICS_OUTPUT_PROTOCOL       *This,
+  IN OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *BltBuffer  OPTIONAL,
+  IN EFI_GRAPHICS_OUTPUT_BLT_OPERATION  BltOperation,
+  IN UINTN                              SourceX,
+  IN UINTN                              SourceY,
+  IN UINTN                              DestinationX,
+  IN UINTN                              DestinationY,
+  IN UINTN                              Width,
+  IN UINTN                              Height,
+  IN UINTN                              Delta       OPTIONAL
+  );
+
 BOOLEAN
 IsDisplayModeSupported (
   IN CONNECTOR_STATE     *ConnectorState,
@@ -5,9 +5,11 @@
  */
 #include <Uefi.h>
 #include "Soc.h"
+#include <Library/BaseLib.h>
 #include <Library/DebugLib.h>
 #include <Library/IoLib.h>
 #include <Library/PcdLib.h>
+#include <Library/SynchronizationLib.h>
 #include <Library/TimerLib.h>
 #include <Library/SpiMem.h>
 #include <Library/Fspi.h>
@@ -21,6 +23,9 @@
 #include <Uefi/UefiBaseType.h>
 #include <Library/UefiRuntimeLib.h>
 #include <Library/BaseMemoryLib.h>
+#include <Library/CruLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+#include <Protocol/VariableWrite.h>
 
 #define HAL_SNOR_DEBUG
 #ifdef HAL_SNOR_DEBUG
@@ -82,8 +87,92 @@ struct FLASH_INFO {
 
 #define READ_MAX_IOSIZE  (1024 * 8)/* 8KB */
 
+#define NOR_DMA_BUFFER_SIZE  SIZE_64KB
+
+/* Delay line calibration */
+#define NOR_CALIB_SPEED          HAL_FSPI_SPEED_THRESHOLD
+#define NOR_CALIB_SFDP_SIZE      64
+#define NOR_CALIB_DATA_SIZE      256
+#define NOR_CALIB_SIZE           (3 + NOR_CALIB_SFDP_SIZE + NOR_CALIB_DATA_SIZE)
+#define NOR_CALIB_MIN_WINDOW     8 /* cells */
+#define NOR_CALIB_VARIABLE_NAME  L"FspiDelayLineCalibration"
+
+/* SFDP (JESD216) */
+#define SFDP_SIGNATURE          0x50444653 /* "SFDP" */
+#define SFDP_HEADER_SIZE        8
+#define SFDP_PARAM_HEADER_SIZE  8
+#define SFDP_MAX_PARAM_HEADERS  16
+#define SFDP_BFPT_ID            0xFF00
+#define SFDP_4BAIT_ID           0xFF84
+#define SFDP_BFPT_MIN_DWORDS    9
+#define SFDP_BFPT_MAX_DWORDS    20
+
+#define SFDP_DWORD(i)  ((i) - 1) /* the standard counts DWORDs from 1 */
+
+/* BFPT DWORD 1 */
+#define BFPT_DW1_ERASE_4K_MASK     (0x3 << 0)
+#define BFPT_DW1_ERASE_4K          (0x1 << 0)
+#define BFPT_DW1_ADDR_BYTES_MASK   (0x3 << 17)
+#define BFPT_DW1_ADDR_BYTES_3      (0x0 << 17)
+#define BFPT_DW1_ADDR_BYTES_4      (0x2 << 17)
+#define BFPT_DW1_FAST_READ_1_1_2   BIT(16)
+#define BFPT_DW1_FAST_READ_1_4_4   BIT(21)
+#define BFPT_DW1_FAST_READ_1_1_4   BIT(22)
+
+/* BFPT DWORD 15 quad enable requirements */
+#define BFPT_DW15_QER_SHIFT  20
+#define BFPT_DW15_QER_MASK   (0x7 << BFPT_DW15_QER_SHIFT)
+#define QER_NONE             0 /* no QE bit, quad is always on */
+#define QER_SR2_BIT1_WR01_A  1 /* SR2 bit 1, 01h writes SR1 and SR2 */
+#define QER_SR1_BIT6         2 /* SR1 bit 6, 01h writes SR1 */
+#define QER_SR2_BIT7         3 /* SR2 bit 7, 3Fh/3Eh, unsupported here */
+#define QER_SR2_BIT1_WR01_B  4 /* SR2 bit 1, 01h writes SR1 and SR2 */
+#define QER_SR2_BIT1_WR01_C  5 /* SR2 bit 1, 35h reads SR2, 01h writes both */
+#define QER_SR2_BIT1_WR31    6 /* SR2 bit 1, 35h reads and 31h writes SR2 */
+
+/* BFPT DWORD 16 */
+#define BFPT_DW16_EN4B_B7          BIT(24)
+#define BFPT_DW16_EN4B_WREN_B7     BIT(25)
+
+/* 4-byte address instruction table DWORD 1 */
+#define SFDP_4BAIT_READ_1_1_4  BIT(4)
+#define SFDP_4BAIT_READ_1_4_4  BIT(5)
+#define SFDP_4BAIT_PP          BIT(6)
+#define SFDP_4BAIT_PP_1_1_4    BIT(7)
+
+#define SPINOR_OP_READ_1_1_4_4B  0x6c
+#define SPINOR_OP_PP_4B          0x12
+#define SPINOR_OP_PP_1_1_4_4B    0x34
+
+/* Erase and program timeouts used when SFDP does not provide them */
+#define SNOR_SECTOR_ERASE_TIMEOUT_MS  400
+#define SNOR_BLOCK_ERASE_TIMEOUT_MS   2000
+#define SNOR_CHIP_ERASE_TIMEOUT_MS    40000
+#define SNOR_PROG_TIMEOUT_US          10000
+
 /********************* Private Structure Definition **************************/
 
+/* Parameters derived from the SFDP basic flash parameter table */
+struct SFDP_INFO {
+  UINT32    size;
+  UINT32    pageSize;
+  UINT8     read144Opcode;  /* 0 if unsupported */
+  UINT8     read144Dummy;   /* wait states plus mode clocks */
+  UINT8     read114Opcode;
+  UINT8     read114Dummy;
+  UINT8     read112Opcode;
+  UINT8     read112Dummy;
+  UINT8     progOpcode;
+  UINT8     prog114Opcode;  /* 0 if unsupported */
+  UINT8     eraseOpcode4K;  /* 0 if unsupported */
+  UINT8     eraseOpcode64K; /* 0 if unsupported */
+  UINT8     QEBits;         /* FLASH_INFO encoding, 0 if none is needed */
+  UINT8     feature;        /* FLASH_INFO feature */
+  BOOLEAN   quadUsable;     /* QE requirement known and supported here */
+  UINT32    eraseTimeoutMs[3];
+  UINT32    progTimeoutUs;
+};
+
 /********************* Private Variable Definition ***************************/
 static const struct FLASH_INFO  s_spiFlashbl[] = {
   /* GD25Q32B */
@@ -209,6 +298,24 @@ static const struct FLASH_INFO  s_spiFlashbl[] = {
 STATIC struct HAL_FSPI_HOST     *g_spi;
 STATIC struct SPI_NOR           *g_nor;
 STATIC EFI_EVENT                mNorVirtualAddrChangeEvent;
+STATIC EFI_EVENT                mNorExitBootServicesEvent;
+STATIC VOID                     *mNorVariableWriteRegistration;
+
+/*
+ * Held for the duration of every protocol call that talks to the flash.
+ * A call that finds it taken preempted another one from an event and
+ * fails with EFI_NOT_READY rather than corrupting the FSPI state.
+ */
+STATIC SPIN_LOCK  mNorLock;
+
+/* Only successful calibrations are saved; a failed one is retried next boot */
+typedef struct {
+  UINT32    JedecId;
+  UINT32    Speed;
+  UINT32    Cell;
+} NOR_CALIBRATION;
+
+STATIC NOR_CALIBRATION  mNorCalibration;
 
 /* Support single line case
  * - id: get from SPI Nor device information
@@ -578,6 +685,7 @@ RETURN_STATUS
 SNOR_ReadSFDP (
   struct SPI_NOR  *nor,
   UINT32          addr,
+  UINT32          len,
   UINT8           *data
   )
 {
@@ -585,12 +693,296 @@ SNOR_ReadSFDP (
                                 HAL_SPI_MEM_OP_CMD (SPINOR_OP_READ_SFDP, 1),
                                 HAL_SPI_MEM_OP_ADDR (3, addr, 1),
                                 HAL_SPI_MEM_OP_DUMMY (1, 1),
-                                HAL_SPI_MEM_OP_DATA_IN (1, data, 1)
+                                HAL_SPI_MEM_OP_DATA_IN (len, data, 1)
                                 );
 
   return HAL_FSPI_SpiXfer (nor->spi, &op);
 }
 
+/*
+ * Decode an SFDP fast read descriptor: wait states in bits 4:0, mode
+ * clocks in bits 7:5 and the opcode in bits 15:8. Mode clocks are sent
+ * as dummy. Returns 0 if the FSPI cannot express the dummy cycle count.
+ */
+static UINT8
+SFDP_GetReadOpcode (
+  UINT16  desc,
+  UINT8   addrLines,
+  UINT8   *dummy
+  )
+{
+  UINT8  cycles = (desc & 0x1F) + ((desc >> 5) & 0x7);
+
+  if ((cycles > 15) || ((cycles * addrLines) & 0x7)) {
+    return 0;
+  }
+
+  *dummy = cycles;
+
+  return desc >> 8;
+}
+
+/*
+ * Max erase time of erase type 0..3 from BFPT DWORD 10: the typical time
+ * scaled by the typical to max multiplier.
+ */
+static UINT32
+SFDP_GetEraseTimeMs (
+  UINT32  dw10,
+  UINT32  type
+  )
+{
+  static const UINT16  unitMs[] = { 1, 16, 128, 1000 };
+  UINT32               field    = (dw10 >> (4 + type * 7)) & 0x7F;
+
+  return 2 * ((dw10 & 0xF) + 1) * ((field & 0x1F) + 1) * unitMs[field >> 5];
+}
+
+/**
+ * @brief  Parse the SFDP basic flash parameter table and, for parts above
+ *         16MB, the 4-byte address instruction table.
+ * @param  nor: nor dev.
+ * @param  sfdp: parsed parameters.
+ * @return RETURN_STATUS.
+ */
+static RETURN_STATUS
+SNOR_ParseSFDP (
+  struct SPI_NOR    *nor,
+  struct SFDP_INFO  *sfdp
+  )
+{
+  static const UINT32  chipUnitMs[] = { 16, 256, 4000, 64000 };
+  UINT8                header[SFDP_PARAM_HEADER_SIZE];
+  UINT32               bfpt[SFDP_BFPT_MAX_DWORDS];
+  UINT32               bait[2];
+  UINT32               bfptAddr = 0, bfptLen = 0, bfptMinor = 0, baitAddr = 0;
+  UINT32               nph, i, id, addr, mult, dw1, dw11;
+  UINT32               eraseType4K = 4, eraseType64K = 4;
+  UINT64               bits, size;
+  UINT16               desc;
+  RETURN_STATUS        ret;
+
+  ZeroMem (sfdp, sizeof (*sfdp));
+
+  ret = SNOR_ReadSFDP (nor, 0, SFDP_HEADER_SIZE, header);
+  if (ret || (ReadUnaligned32 ((UINT32 *)header) != SFDP_SIGNATURE) || (header[5] != 1)) {
+    return RETURN_UNSUPPORTED;
+  }
+
+  /* parameter header 0 is always the BFPT, later ones may be newer BFPT revisions */
+  nph = MIN (header[6] + 1, SFDP_MAX_PARAM_HEADERS);
+  for (i = 0; i < nph; i++) {
+    ret = SNOR_ReadSFDP (nor, SFDP_HEADER_SIZE + i * SFDP_PARAM_HEADER_SIZE, SFDP_PARAM_HEADER_SIZE, header);
+    if (ret) {
+      return ret;
+    }
+
+    id   = header[7] << 8 | header[0];
+    addr = header[4] | header[5] << 8 | header[6] << 16;
+    if (header[2] != 1) {
+      continue;
+    }
+
+    if ((id == SFDP_BFPT_ID) && ((bfptLen == 0) || (header[1] > bfptMinor))) {
+      bfptAddr  = addr;
+      bfptLen   = header[3];
+      bfptMinor = header[1];
+    } else if ((id == SFDP_4BAIT_ID) && (header[3] >= 2)) {
+      baitAddr = addr;
+    }
+  }
+
+  if (bfptLen < SFDP_BFPT_MIN_DWORDS) {
+    return RETURN_UNSUPPORTED;
+  }
+
+  bfptLen = MIN (bfptLen, SFDP_BFPT_MAX_DWORDS);
+  ZeroMem (bfpt, sizeof (bfpt));
+  ret = SNOR_ReadSFDP (nor, bfptAddr, bfptLen * 4, (UINT8 *)bfpt);
+  if (ret) {
+    return ret;
+  }
+
+  /* density, in bits */
+  bits = bfpt[SFDP_DWORD (2)];
+  if (bits & BIT31) {
+    bits &= ~BIT31;
+    if ((bits < 15) || (bits > 34)) {
+      return RETURN_UNSUPPORTED;
+    }
+
+    size = LShiftU64 (1, (UINTN)bits - 3);
+  } else {
+    size = (bits + 1) >> 3;
+  }
+
+  if ((size < SIZE_64KB) || (size > SIZE_2GB) || (size & (size - 1))) {
+    return RETURN_UNSUPPORTED;
+  }
+
+  sfdp->size     = (UINT32)size;
+  sfdp->pageSize = 256;
+  if (bfptLen >= 11) {
+    i = (bfpt[SFDP_DWORD (11)] >> 4) & 0xF;
+    if ((i >= 6) && (i <= 12)) {
+      sfdp->pageSize = 1 << i;
+    }
+  }
+
+  /* erase types, sizes are powers of two */
+  for (i = 0; i < 4; i++) {
+    desc = (UINT16)(bfpt[SFDP_DWORD (8) + i / 2] >> ((i & 1) * 16));
+    if (((desc & 0xFF) == 12) && (eraseType4K == 4)) {
+      eraseType4K         = i;
+      sfdp->eraseOpcode4K = desc >> 8;
+    } else if (((desc & 0xFF) == 16) && (eraseType64K == 4)) {
+      eraseType64K         = i;
+      sfdp->eraseOpcode64K = desc >> 8;
+    }
+  }
+
+  if (!sfdp->eraseOpcode4K &&
+      ((bfpt[SFDP_DWORD (1)] & BFPT_DW1_ERASE_4K_MASK) == BFPT_DW1_ERASE_4K))
+  {
+    sfdp->eraseOpcode4K = (bfpt[SFDP_DWORD (1)] >> 8) & 0xFF;
+  }
+
+  /* timings, JESD216A and later */
+  sfdp->eraseTimeoutMs[ERASE_SECTOR]   = SNOR_SECTOR_ERASE_TIMEOUT_MS;
+  sfdp->eraseTimeoutMs[ERASE_BLOCK64K] = SNOR_BLOCK_ERASE_TIMEOUT_MS;
+  sfdp->eraseTimeoutMs[ERASE_CHIP]     = SNOR_CHIP_ERASE_TIMEOUT_MS;
+  sfdp->progTimeoutUs                  = SNOR_PROG_TIMEOUT_US;
+  if (bfptLen >= 11) {
+    if (eraseType4K < 4) {
+      sfdp->eraseTimeoutMs[ERASE_SECTOR] = SFDP_GetEraseTimeMs (bfpt[SFDP_DWORD (10)], eraseType4K);
+    }
+
+    if (eraseType64K < 4) {
+      sfdp->eraseTimeoutMs[ERASE_BLOCK64K] = SFDP_GetEraseTimeMs (bfpt[SFDP_DWORD (10)], eraseType64K);
+    }
+
+    dw11                             = bfpt[SFDP_DWORD (11)];
+    mult                             = 2 * ((dw11 & 0xF) + 1);
+    sfdp->eraseTimeoutMs[ERASE_CHIP] = mult * (((dw11 >> 24) & 0x1F) + 1) * chipUnitMs[(dw11 >> 29) & 0x3];
+    sfdp->progTimeoutUs              = mult * (((dw11 >> 8) & 0x1F) + 1) * ((dw11 & BIT13) ? 64 : 8);
+  }
+
+  /* fast reads */
+  dw1 = bfpt[SFDP_DWORD (1)];
+  if (dw1 & BFPT_DW1_FAST_READ_1_4_4) {
+    sfdp->read144Opcode = SFDP_GetReadOpcode ((UINT16)bfpt[SFDP_DWORD (3)], 4, &sfdp->read144Dummy);
+  }
+
+  if (dw1 & BFPT_DW1_FAST_READ_1_1_4) {
+    sfdp->read114Opcode = SFDP_GetReadOpcode ((UINT16)(bfpt[SFDP_DWORD (3)] >> 16), 1, &sfdp->read114Dummy);
+  }
+
+  if (dw1 & BFPT_DW1_FAST_READ_1_1_2) {
+    sfdp->read112Opcode = SFDP_GetReadOpcode ((UINT16)bfpt[SFDP_DWORD (4)], 1, &sfdp->read112Dummy);
+  }
+
+  sfdp->progOpcode    = SPINOR_OP_PP;
+  sfdp->prog114Opcode = 0;
+
+  /* quad enable requirements, JESD216A and later */
+  sfdp->feature = FEA_STATUE_MODE0;
+  if (bfptLen >= 15) {
+    sfdp->quadUsable = TRUE;
+    switch ((bfpt[SFDP_DWORD (15)] & BFPT_DW15_QER_MASK) >> BFPT_DW15_QER_SHIFT) {
+      case QER_NONE:
+        sfdp->QEBits = 0;
+        break;
+      case QER_SR1_BIT6:
+        sfdp->QEBits = 6;
+        break;
+      case QER_SR2_BIT1_WR01_A:
+      case QER_SR2_BIT1_WR01_B:
+      case QER_SR2_BIT1_WR01_C:
+        sfdp->QEBits  = 9;
+        sfdp->feature = FEA_STATUE_MODE1;
+        break;
+      case QER_SR2_BIT1_WR31:
+        sfdp->QEBits = 9;
+        break;
+      default:
+        sfdp->quadUsable = FALSE;
+        break;
+    }
+  }
+
+  /* addressing */
+  if ((dw1 & BFPT_DW1_ADDR_BYTES_MASK) == BFPT_DW1_ADDR_BYTES_4) {
+    sfdp->feature |= FEA_4BYTE_ADDR;
+  } else if (sfdp->size > SIZE_16MB) {
+    ZeroMem (bait, sizeof (bait));
+    if ((dw1 & BFPT_DW1_ADDR_BYTES_MASK) == BFPT_DW1_ADDR_BYTES_3) {
+      baitAddr = 0;
+    } else if (baitAddr) {
+      ret = SNOR_ReadSFDP (nor, baitAddr, sizeof (bait), (UINT8 *)bait);
+      if (ret) {
+        return ret;
+      }
+    }
+
+    if ((bait[0] & SFDP_4BAIT_PP) && (eraseType4K < 4) && (eraseType64K < 4) &&
+        (bait[0] & BIT (9 + eraseType4K)) && (bait[0] & BIT (9 + eraseType64K)))
+    {
+      /* dedicated 4-byte opcodes, dummy cycles are the same as the 3-byte ones */
+      sfdp->feature       |= FEA_4BYTE_ADDR;
+      sfdp->eraseOpcode4K  = (bait[1] >> (eraseType4K * 8)) & 0xFF;
+      sfdp->eraseOpcode64K = (bait[1] >> (eraseType64K * 8)) & 0xFF;
+      sfdp->progOpcode     = SPINOR_OP_PP_4B;
+      sfdp->prog114Opcode  = (bait[0] & SFDP_4BAIT_PP_1_1_4) ? SPINOR_OP_PP_1_1_4_4B : 0;
+      sfdp->read144Opcode  = ((bait[0] & SFDP_4BAIT_READ_1_4_4) && sfdp->read144Opcode) ? SPINOR_OP_READ_EC : 0;
+      sfdp->read114Opcode  = ((bait[0] & SFDP_4BAIT_READ_1_1_4) && sfdp->read114Opcode) ? SPINOR_OP_READ_1_1_4_4B : 0;
+      sfdp->read112Opcode  = 0;
+    } else if ((bfptLen >= 16) && (bfpt[SFDP_DWORD (16)] & BFPT_DW16_EN4B_B7)) {
+      sfdp->feature |= FEA_4BYTE_ADDR | FEA_4BYTE_ADDR_MODE;
+    } else {
+      sfdp->size = SIZE_16MB;
+    }
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/*
+ * Describe a part that is not in s_spiFlashbl from its SFDP parameters.
+ * Requires 4KB sector and 64KB block erase, which the rest of the driver
+ * relies on.
+ */
+static BOOLEAN
+SNOR_InfoFromSFDP (
+  const struct SFDP_INFO  *sfdp,
+  const UINT8             *flashId,
+  struct FLASH_INFO       *info
+  )
+{
+  if (!sfdp->eraseOpcode4K || !sfdp->eraseOpcode64K) {
+    return FALSE;
+  }
+
+  info->id             = (flashId[0] << 16) | (flashId[1] << 8) | flashId[2];
+  info->blockSize      = 128;
+  info->sectorSize     = 8;
+  info->readCmd        = (sfdp->progOpcode == SPINOR_OP_PP_4B) ? 0x13 : SPINOR_OP_READ;
+  info->progCmd        = sfdp->progOpcode;
+  info->readCmd_4      = 0;
+  info->progCmd_4      = 0;
+  info->sectorEraseCmd = sfdp->eraseOpcode4K;
+  info->blockEraseCmd  = sfdp->eraseOpcode64K;
+  info->feature        = sfdp->feature;
+  info->density        = HighBitSet32 (sfdp->size) - 9;
+  info->QEBits         = sfdp->QEBits;
+
+  if (sfdp->quadUsable) {
+    info->readCmd_4 = sfdp->read144Opcode ? sfdp->read144Opcode : sfdp->read114Opcode;
+    info->progCmd_4 = sfdp->prog114Opcode;
+  }
+
+  return TRUE;
+}
+
 static void *
 SNOR_InfoAdjust (
   struct SPI_NOR     *nor,
@@ -602,7 +994,7 @@ SNOR_InfoAdjust (
 
   if (info->id == 0xc84019) {
     addr = 0x09;
-    SNOR_ReadSFDP (nor, addr, &para);
+    SNOR_ReadSFDP (nor, addr, 1, &para);
     if (para == 0x06) {
       info->QEBits    = 9;
       info->progCmd_4 = 0x34;
@@ -630,15 +1022,18 @@ HAL_SNOR_ReadData (
 {
   RETURN_STATUS  ret;
   UINT8          *pBuf = (UINT8 *)buf;
-  UINT32         size, remain = len;
+  UINT32         size, remain = len, maxSize;
 
   /* DEBUG ((DEBUG_SNOR, "%s from 0x%08lx, len %lx\n", __func__, from, len)); */
   if ((from >= nor->size) || (len > nor->size) || ((from + len) > nor->size)) {
     return RETURN_DEVICE_ERROR;
   }
 
+  /* DMA transfers are bounded by the bounce buffer rather than the FIFO loop */
+  maxSize = nor->spi->dmaBuf ? nor->spi->dmaBufSize : READ_MAX_IOSIZE;
+
   while (remain) {
-    size = MIN (READ_MAX_IOSIZE, remain);
+    size = MIN (maxSize, remain);
     ret  = SNOR_ReadData (nor, from, size, pBuf);
     if (ret != (RETURN_STATUS)size) {
       DEBUG ((DEBUG_SNOR, "%s %lu ret= %ld\n", __func__, from >> 9, ret));
@@ -690,7 +1085,7 @@ HAL_SNOR_ProgData (
       return ret;
     }
 
-    SNOR_WaitBusy (nor, 10000);
+    SNOR_WaitBusy (nor, nor->progTimeoutUs);
     remain -= size;
     to     += size;
     pBuf   += size;
@@ -714,7 +1109,6 @@ HAL_SNOR_Erase (
   )
 {
   RETURN_STATUS  ret;
-  INT32          timeout[] = { 400, 2000, 40000 };
 
   /* DEBUG ((DEBUG_SNOR, "%s addr %lx\n", __func__, addr)); */
   if (addr >= nor->size) {
@@ -734,7 +1128,7 @@ HAL_SNOR_Erase (
     return ret;
   }
 
-  return SNOR_WaitBusy (nor, timeout[eraseType] * 1000);
+  return SNOR_WaitBusy (nor, nor->eraseTimeoutMs[eraseType] * 1000);
 }
 
 /**
@@ -855,6 +1249,8 @@ HAL_SNOR_Init (
   UINT8                    idByte[5];
   const struct FLASH_INFO  *info;
   INT32                    ret = RETURN_SUCCESS;
+  struct SFDP_INFO         sfdp;
+  BOOLEAN                  hasSfdp;
 
   if (!nor->spi) {
     DEBUG ((DEBUG_SNOR, "%a no host\n", __func__));
@@ -874,8 +1270,13 @@ HAL_SNOR_Init (
     return RETURN_DEVICE_ERROR;
   }
 
+  hasSfdp = SNOR_ParseSFDP (nor, &sfdp) == RETURN_SUCCESS;
+  DEBUG ((DEBUG_SNOR, "SPI Nor SFDP: %a\n", hasSfdp ? "yes" : "no"));
+
   info = SNOR_GerFlashInfo (idByte);
-  if (!info) {
+  if (!info && hasSfdp && SNOR_InfoFromSFDP (&sfdp, idByte, &s_commonSpiFlash)) {
+    info = &s_commonSpiFlash;
+  } else if (!info) {
     if (nor->spi->mode & HAL_SPI_RX_QUAD ||
         nor->spi->mode & HAL_SPI_TX_QUAD)
     {
@@ -903,7 +1304,13 @@ HAL_SNOR_Init (
   nor->sectorSize = info->sectorSize * 512;
   nor->size       = 1 << (info->density + 9);
   nor->eraseSize  = nor->sectorSize;
-  if (nor->spi->mode & HAL_SPI_RX_QUAD) {
+
+  nor->eraseTimeoutMs[ERASE_SECTOR]   = SNOR_SECTOR_ERASE_TIMEOUT_MS;
+  nor->eraseTimeoutMs[ERASE_BLOCK64K] = SNOR_BLOCK_ERASE_TIMEOUT_MS;
+  nor->eraseTimeoutMs[ERASE_CHIP]     = SNOR_CHIP_ERASE_TIMEOUT_MS;
+  nor->progTimeoutUs                  = SNOR_PROG_TIMEOUT_US;
+
+  if ((nor->spi->mode & HAL_SPI_RX_QUAD) && info->readCmd_4) {
     ret = RETURN_SUCCESS;
     if (info->QEBits) {
       ret = SNOR_EnableQE (nor);
@@ -913,6 +1320,7 @@ HAL_SNOR_Init (
       nor->readOpcode = info->readCmd_4;
       switch (nor->readOpcode) {
         case SPINOR_OP_READ_1_4_4:
+        case SPINOR_OP_READ_EC:
           nor->readDummy = 6;
           nor->readProto = SNOR_PROTO_1_4_4;
           break;
@@ -929,7 +1337,7 @@ HAL_SNOR_Init (
   }
 
   if (nor->spi->mode & HAL_SPI_TX_QUAD &&
-      info->QEBits)
+      info->QEBits && info->progCmd_4)
   {
     if (SNOR_EnableQE (nor) == RETURN_SUCCESS) {
       nor->programOpcode = info->progCmd_4;
@@ -952,6 +1360,26 @@ HAL_SNOR_Init (
     SNOR_Enter4byte (nor);
   }
 
+  /* SFDP knows better than the defaults above */
+  if (hasSfdp) {
+    nor->pageSize = sfdp.pageSize;
+    CopyMem (nor->eraseTimeoutMs, sfdp.eraseTimeoutMs, sizeof (nor->eraseTimeoutMs));
+    nor->progTimeoutUs = sfdp.progTimeoutUs;
+
+    if ((nor->readProto == SNOR_PROTO_1_4_4) && (nor->readOpcode == sfdp.read144Opcode)) {
+      nor->readDummy = sfdp.read144Dummy;
+    } else if ((nor->readProto == SNOR_PROTO_1_1_4) && (nor->readOpcode == sfdp.read114Opcode)) {
+      nor->readDummy = sfdp.read114Dummy;
+    } else if ((nor->readProto == SNOR_PROTO_1_1_1) && (info == &s_commonSpiFlash) && sfdp.read112Opcode &&
+               (nor->spi->mode & (HAL_SPI_RX_DUAL | HAL_SPI_RX_QUAD)))
+    {
+      /* quad unusable, but dual output read is */
+      nor->readOpcode = sfdp.read112Opcode;
+      nor->readDummy  = sfdp.read112Dummy;
+      nor->readProto  = SNOR_PROTO_1_1_2;
+    }
+  }
+
   DEBUG ((DEBUG_SNOR, "nor->addrWidth: %x\n", nor->addrWidth));
   DEBUG ((DEBUG_SNOR, "nor->readProto: %x\n", nor->readProto));
   DEBUG ((DEBUG_SNOR, "nor->writeProto: %x\n", nor->writeProto));
@@ -961,6 +1389,15 @@ HAL_SNOR_Init (
   DEBUG ((DEBUG_SNOR, "nor->eraseOpcodeSec: %x\n", nor->eraseOpcodeSec));
   DEBUG ((DEBUG_SNOR, "nor->size: %ldMB\n", nor->size >> 20));
   DEBUG ((DEBUG_SNOR, "nor->size: %ldMB\n", nor->size >> 20));
+  DEBUG ((DEBUG_SNOR, "nor->readDummy: %d\n", nor->readDummy));
+  DEBUG ((DEBUG_SNOR, "nor->pageSize: %d\n", nor->pageSize));
+  DEBUG ((
+    DEBUG_SNOR,
+    "nor->eraseTimeout: %d/%d/%dms\n",
+    nor->eraseTimeoutMs[ERASE_SECTOR],
+    nor->eraseTimeoutMs[ERASE_BLOCK64K],
+    nor->eraseTimeoutMs[ERASE_CHIP]
+    ));
 
   return RETURN_SUCCESS;
 }
@@ -1070,10 +1507,6 @@ Erase (
   EFI_STATUS  Status;
   UINTN       EraseSize;
 
-  if (EfiAtRuntime ()) {
-    NorFspiEnableClock (g_nor->spi->CruBase);
-  }
-
   EraseSize = g_nor->sectorSize;
 
   // Check input parameters
@@ -1082,18 +1515,29 @@ Erase (
     return EFI_DEVICE_ERROR;
   }
 
+  if (!AcquireSpinLockOrFail (&mNorLock)) {
+    return EFI_NOT_READY;
+  }
+
+  if (EfiAtRuntime ()) {
+    NorFspiEnableClock (g_nor->spi->CruBase);
+  }
+
+  Status = EFI_SUCCESS;
   while (ulLen) {
     Status = HAL_SNOR_Erase (g_nor, Offset, ERASE_SECTOR);
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "SpiFlash: Error while erase target address\n"));
-      return Status;
+      break;
     }
 
     Offset += EraseSize;
     ulLen  -= EraseSize;
   }
 
-  return EFI_SUCCESS;
+  ReleaseSpinLock (&mNorLock);
+
+  return Status;
 }
 
 UINT32
@@ -1114,6 +1558,10 @@ Write (
 {
   EFI_STATUS  Status = EFI_SUCCESS;
 
+  if (!AcquireSpinLockOrFail (&mNorLock)) {
+    return EFI_NOT_READY;
+  }
+
   if (EfiAtRuntime ()) {
     NorFspiEnableClock (g_nor->spi->CruBase);
   }
@@ -1124,6 +1572,8 @@ Write (
     DEBUG ((DEBUG_ERROR, "SpiFlash: Error while programming target address\n"));
   }
 
+  ReleaseSpinLock (&mNorLock);
+
   return Status;
 }
 
@@ -1137,72 +1587,167 @@ Read (
 {
   EFI_STATUS  Status = EFI_SUCCESS;
 
+  if (!AcquireSpinLockOrFail (&mNorLock)) {
+    return EFI_NOT_READY;
+  }
+
   if (EfiAtRuntime ()) {
     NorFspiEnableClock (g_nor->spi->CruBase);
   }
 
   // DEBUG ((DEBUG_ERROR, "[%a]:[%dL]: %x!......................\n", __FUNCTION__,__LINE__,Offset));
   Status = HAL_SNOR_ReadData (g_nor, Offset, Buffer, ulLen);
+
+  ReleaseSpinLock (&mNorLock);
+
   return Status;
 }
 
+#define NOR_BLOCK_SIZE  SIZE_64KB
+
+STATIC
+BOOLEAN
+SpiFlashIsErased (
+  IN UINT8  *Buf,
+  IN UINTN  Size
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Size; Index++) {
+    if (Buf[Index] != 0xFF) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Update part of a single 64 KiB erase block.
+
+  Only sectors whose contents actually change are touched. Of those, the
+  ones that are already blank are programmed without an erase, and the
+  whole block is erased at once when every sector in it needs erasing.
+  Pages that are blank after the merge are not programmed.
+
+  @param[in]  BlockOffset   Flash offset of the erase block.
+  @param[in]  Start         Offset of the new data within the block.
+  @param[in]  Length        Length of the new data.
+  @param[in]  Buf           New data.
+  @param[in]  BlockBuf      Scratch buffer of NOR_BLOCK_SIZE bytes.
+**/
 STATIC
 EFI_STATUS
 SpiFlashUpdateBlock (
-  IN UINT32  Offset,
-  IN UINT32  Align,
-  IN UINTN   ToUpdate,
+  IN UINT32  BlockOffset,
+  IN UINT32  Start,
+  IN UINT32  Length,
   IN UINT8   *Buf,
-  IN UINT8   *TmpBuf,
-  IN UINTN   EraseSize
+  IN UINT8   *BlockBuf
   )
 {
   EFI_STATUS  Status;
-
-  if (EfiAtRuntime ()) {
-    NorFspiEnableClock (g_nor->spi->CruBase);
+  UINT32      SectorSize;
+  UINT32      PageSize;
+  UINT32      FirstSector;
+  UINT32      LastSector;
+  UINT32      Sector;
+  UINT32      SectorStart;
+  UINT32      OverlapStart;
+  UINT32      OverlapEnd;
+  UINT32      DirtyMask;
+  UINT32      EraseMask;
+  UINT32      RunStart;
+  UINT32      Page;
+
+  SectorSize  = g_nor->sectorSize;
+  PageSize    = g_nor->pageSize;
+  FirstSector = Start / SectorSize;
+  LastSector  = (Start + Length - 1) / SectorSize;
+
+  ASSERT (NOR_BLOCK_SIZE / SectorSize <= 32);
+
+  // Read current contents of the covered sectors
+  Status = HAL_SNOR_ReadData (
+             g_nor,
+             BlockOffset + FirstSector * SectorSize,
+             &BlockBuf[FirstSector * SectorSize],
+             (LastSector - FirstSector + 1) * SectorSize
+             );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "SpiFlash: Update: Error while reading old data\n"));
+    return Status;
   }
 
-  // Read backup
-  if (ToUpdate != EraseSize) {
-    Status = HAL_SNOR_ReadData (g_nor, Offset - Align, TmpBuf, EraseSize);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "SpiFlash: Update: Error while reading old data\n"));
-      return Status;
+  DirtyMask = 0;
+  EraseMask = 0;
+  for (Sector = FirstSector; Sector <= LastSector; Sector++) {
+    SectorStart  = Sector * SectorSize;
+    OverlapStart = MAX (SectorStart, Start);
+    OverlapEnd   = MIN (SectorStart + SectorSize, Start + Length);
+
+    if (CompareMem (&BlockBuf[OverlapStart], &Buf[OverlapStart - Start], OverlapEnd - OverlapStart) == 0) {
+      continue;
+    }
+
+    DirtyMask |= 1U << Sector;
+    if (!SpiFlashIsErased (&BlockBuf[SectorStart], SectorSize)) {
+      EraseMask |= 1U << Sector;
     }
   }
 
-  // Erase entire sector
-  Status = HAL_SNOR_Erase (g_nor, Offset, ERASE_SECTOR);
-  if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "SpiFlash: Update: Error while erasing block\n"));
-    return Status;
+  if (DirtyMask == 0) {
+    return EFI_SUCCESS;
   }
 
-  if (Align) {
-    CopyMem (&TmpBuf[Align], Buf, ToUpdate);
-    Status = HAL_SNOR_ProgData (g_nor, Offset - Align, TmpBuf, EraseSize);
+  CopyMem (&BlockBuf[Start], Buf, Length);
+
+  // Erase
+  if (EraseMask == (UINT32)(((UINT64)1 << (NOR_BLOCK_SIZE / SectorSize)) - 1)) {
+    Status = HAL_SNOR_Erase (g_nor, BlockOffset, ERASE_BLOCK64K);
     if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "SpiFlash: Update: Error while writing new data\n"));
+      DEBUG ((DEBUG_ERROR, "SpiFlash: Update: Error while erasing block\n"));
       return Status;
     }
+  } else {
+    for (Sector = FirstSector; Sector <= LastSector; Sector++) {
+      if ((EraseMask & (1U << Sector)) == 0) {
+        continue;
+      }
 
-    return EFI_SUCCESS;
+      Status = HAL_SNOR_Erase (g_nor, BlockOffset + Sector * SectorSize, ERASE_SECTOR);
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "SpiFlash: Update: Error while erasing sector\n"));
+        return Status;
+      }
+    }
   }
 
-  // Write new data
-  Status = HAL_SNOR_ProgData (g_nor, Offset, Buf, ToUpdate);
-  if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "SpiFlash: Update: Error while writing new data\n"));
-    return Status;
-  }
+  // Program the non-blank pages of every dirty sector, in contiguous runs
+  for (Sector = FirstSector; Sector <= LastSector; Sector++) {
+    if ((DirtyMask & (1U << Sector)) == 0) {
+      continue;
+    }
 
-  // Write backup
-  if (ToUpdate != EraseSize) {
-    Status = HAL_SNOR_ProgData (g_nor, Offset + ToUpdate, &TmpBuf[ToUpdate], EraseSize - ToUpdate);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "SpiFlash: Update: Error while writing backup\n"));
-      return Status;
+    SectorStart = Sector * SectorSize;
+    RunStart    = SectorStart;
+    for (Page = SectorStart; Page <= SectorStart + SectorSize; Page += PageSize) {
+      if (  (Page < SectorStart + SectorSize)
+         && !SpiFlashIsErased (&BlockBuf[Page], PageSize))
+      {
+        continue;
+      }
+
+      if (Page > RunStart) {
+        Status = HAL_SNOR_ProgData (g_nor, BlockOffset + RunStart, &BlockBuf[RunStart], Page - RunStart);
+        if (EFI_ERROR (Status)) {
+          DEBUG ((DEBUG_ERROR, "SpiFlash: Update: Error while writing new data\n"));
+          return Status;
+        }
+      }
+
+      RunStart = Page + PageSize;
     }
   }
 
@@ -1218,29 +1763,37 @@ Update (
   )
 {
   EFI_STATUS  Status = EFI_SUCCESS;
-  UINT64      SectorSize, ToUpdate, Align, Scale = 1;
-  UINT8       *TmpBuf, *End;
+  UINT64      ToUpdate, Start, Scale = 1;
+  UINT8       *BlockBuf, *End;
 
   // DEBUG ((DEBUG_ERROR, "[%a]:%x %x!......................\n", __FUNCTION__, Offset, ulLength));
 
-  SectorSize = g_nor->sectorSize;
-  Align      = Offset & (SectorSize -1);
-  End        = Buffer + ulLength;
+  End = Buffer + ulLength;
 
-  TmpBuf = (UINT8 *)AllocateZeroPool (SectorSize);
-  if (TmpBuf == NULL) {
+  BlockBuf = (UINT8 *)AllocatePool (NOR_BLOCK_SIZE);
+  if (BlockBuf == NULL) {
     DEBUG ((DEBUG_ERROR, "SpiFlash: Cannot allocate memory\n"));
     return EFI_OUT_OF_RESOURCES;
   }
 
+  if (!AcquireSpinLockOrFail (&mNorLock)) {
+    FreePool (BlockBuf);
+    return EFI_NOT_READY;
+  }
+
+  if (EfiAtRuntime ()) {
+    NorFspiEnableClock (g_nor->spi->CruBase);
+  }
+
   if (End - Buffer >= 200) {
     Scale = (End - Buffer) / 100;
   }
 
   for ( ; Buffer < End; Buffer += ToUpdate, Offset += ToUpdate) {
-    ToUpdate = MIN ((UINT64)(End - Buffer), SectorSize);
+    Start    = Offset & (NOR_BLOCK_SIZE - 1);
+    ToUpdate = MIN ((UINT64)(End - Buffer), NOR_BLOCK_SIZE - Start);
     Print (L"   \rUpdating, %d%%", 100 - (End - Buffer) / Scale);
-    Status = SpiFlashUpdateBlock (Offset, Align, ToUpdate, Buffer, TmpBuf, SectorSize);
+    Status = SpiFlashUpdateBlock ((UINT32)(Offset - Start), (UINT32)Start, (UINT32)ToUpdate, Buffer, BlockBuf);
 
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "SpiFlash: Error while updating\n"));
@@ -1248,8 +1801,10 @@ Update (
     }
   }
 
+  ReleaseSpinLock (&mNorLock);
+
   Print (L"\n");
-  FreePool (TmpBuf);
+  FreePool (BlockBuf);
 
   return Status;
 }
@@ -1352,6 +1907,279 @@ NorVirtualNotifyEvent (
   return;
 }
 
+/**
+  Stop using DMA once boot services are gone, as the bounce buffer is
+  boot services memory and runtime callers may run with a virtual map.
+
+  @param[in]    Event   The Event that is being processed
+  @param[in]    Context Event Context
+**/
+STATIC
+VOID
+EFIAPI
+NorExitBootServicesEvent (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  g_nor->spi->dmaBuf     = NULL;
+  g_nor->spi->dmaBufSize = 0;
+}
+
+/**
+  Read the calibration pattern: the JEDEC ID, the start of the SFDP table,
+  and the start of the array through the regular (possibly quad) read
+  command. The SFDP table keeps the pattern non-uniform on blank parts.
+
+  @param[out]   Buf     NOR_CALIB_SIZE bytes
+
+  @return TRUE if all reads completed.
+**/
+STATIC
+BOOLEAN
+NorCalibReadPattern (
+  OUT UINT8  *Buf
+  )
+{
+  if (HAL_SNOR_ReadID (g_nor, Buf) != RETURN_SUCCESS) {
+    return FALSE;
+  }
+
+  Buf += 3;
+  if (SNOR_ReadSFDP (g_nor, 0, NOR_CALIB_SFDP_SIZE, Buf) != RETURN_SUCCESS) {
+    return FALSE;
+  }
+
+  Buf += NOR_CALIB_SFDP_SIZE;
+  return HAL_SNOR_ReadData (g_nor, 0, Buf, NOR_CALIB_DATA_SIZE) == NOR_CALIB_DATA_SIZE;
+}
+
+/**
+  Check that the pattern read after the JEDEC ID has some variation in it.
+  A uniform pattern, e.g. a blank part without SFDP, reads back the same
+  for any delay line cell that samples a stable level, so it can't be
+  used to find the sampling window.
+
+  @param[in]    Buf     NOR_CALIB_SIZE bytes
+
+  @return TRUE if the pattern is uniform.
+**/
+STATIC
+BOOLEAN
+NorCalibPatternIsUniform (
+  IN CONST UINT8  *Buf
+  )
+{
+  UINT32  Index;
+
+  for (Index = 4; Index < NOR_CALIB_SIZE; Index++) {
+    if (Buf[Index] != Buf[3]) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Switch to a calibrated clock and delay line, and check the pattern still
+  reads back. Returns to the original clock with the delay line off if not.
+
+  @param[in]    Calib   Calibration to apply
+  @param[in]    Ref     Pattern read at the original clock
+  @param[in]    Rate    The original clock
+
+  @return TRUE if the calibration is in effect.
+**/
+STATIC
+BOOLEAN
+NorCalibApply (
+  IN CONST NOR_CALIBRATION  *Calib,
+  IN CONST UINT8            *Ref,
+  IN UINT32                 Rate
+  )
+{
+  UINT8  Buf[NOR_CALIB_SIZE];
+
+  if (Calib->Speed == 0) {
+    return FALSE;
+  }
+
+  if (HAL_CRU_ClkSetFreq (SCLK_SFC, Calib->Speed) == HAL_OK) {
+    HAL_FSPI_SetDelayLines (g_spi, (UINT8)Calib->Cell);
+    if (NorCalibReadPattern (Buf) && (CompareMem (Buf, Ref, sizeof (Buf)) == 0)) {
+      g_spi->cell = (UINT8)Calib->Cell;
+      return TRUE;
+    }
+  }
+
+  HAL_FSPI_DLLDisable (g_spi);
+  HAL_CRU_ClkSetFreq (SCLK_SFC, Rate);
+
+  return FALSE;
+}
+
+/**
+  Raise the FSPI clock to NOR_CALIB_SPEED, sampling with the RX delay line
+  at the centre of the widest window of cells that read the calibration
+  pattern back correctly.
+
+  A successful result is kept in a variable keyed by JEDEC ID; when that
+  variable is readable at this point and the cached cell still works, the
+  sweep is skipped. A failed sweep is not saved, so it is retried on the
+  next boot.
+**/
+STATIC
+VOID
+NorCalibrate (
+  VOID
+  )
+{
+  EFI_STATUS       Status;
+  UINT8            Ref[NOR_CALIB_SIZE];
+  UINT8            Buf[NOR_CALIB_SIZE];
+  UINT32           Rate;
+  UINT32           Cell;
+  UINT32           Start, BestStart, BestLen;
+  UINTN            Size;
+  NOR_CALIBRATION  Cached;
+
+  Rate = HAL_CRU_ClkGetFreq (SCLK_SFC);
+  if ((Rate == 0) || (Rate >= NOR_CALIB_SPEED)) {
+    return;
+  }
+
+  if (!NorCalibReadPattern (Ref)) {
+    return;
+  }
+
+  if (NorCalibPatternIsUniform (Ref)) {
+    DEBUG ((DEBUG_WARN, "%a: Uniform calibration pattern, staying at %u Hz\n", __FUNCTION__, Rate));
+    return;
+  }
+
+  mNorCalibration.JedecId = Ref[0] << 16 | Ref[1] << 8 | Ref[2];
+  mNorCalibration.Speed   = NOR_CALIB_SPEED;
+
+  Size   = sizeof (Cached);
+  Status = gRT->GetVariable (
+                  NOR_CALIB_VARIABLE_NAME,
+                  &gRockchipFspiCalibrationGuid,
+                  NULL,
+                  &Size,
+                  &Cached
+                  );
+  if (!EFI_ERROR (Status) && (Size == sizeof (Cached)) &&
+      (Cached.JedecId == mNorCalibration.JedecId))
+  {
+    if (NorCalibApply (&Cached, Ref, Rate)) {
+      mNorCalibration = Cached;
+      return;
+    }
+  }
+
+  if (HAL_CRU_ClkSetFreq (SCLK_SFC, NOR_CALIB_SPEED) != HAL_OK) {
+    mNorCalibration.JedecId = 0;
+    return;
+  }
+
+  BestStart = 0;
+  BestLen   = 0;
+  Start     = MAX_UINT32;
+  for (Cell = 0; Cell <= HAL_FSPI_MAX_DELAY_LINE_CELLS; Cell++) {
+    HAL_FSPI_SetDelayLines (g_spi, (UINT8)Cell);
+    if (NorCalibReadPattern (Buf) && (CompareMem (Buf, Ref, sizeof (Buf)) == 0)) {
+      if (Start == MAX_UINT32) {
+        Start = Cell;
+      }
+
+      if (Cell - Start + 1 > BestLen) {
+        BestStart = Start;
+        BestLen   = Cell - Start + 1;
+      }
+    } else {
+      Start = MAX_UINT32;
+    }
+  }
+
+  HAL_FSPI_DLLDisable (g_spi);
+  HAL_CRU_ClkSetFreq (SCLK_SFC, Rate);
+
+  if (BestLen < NOR_CALIB_MIN_WINDOW) {
+    DEBUG ((DEBUG_WARN, "%a: No delay line window at %u Hz, staying at %u Hz\n", __FUNCTION__, NOR_CALIB_SPEED, Rate));
+    mNorCalibration.JedecId = 0;
+    return;
+  }
+
+  mNorCalibration.Cell = BestStart + BestLen / 2;
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: cells %u-%u pass, using %u at %u Hz\n",
+    __FUNCTION__,
+    BestStart,
+    BestStart + BestLen - 1,
+    mNorCalibration.Cell,
+    NOR_CALIB_SPEED
+    ));
+
+  if (!NorCalibApply (&mNorCalibration, Ref, Rate)) {
+    mNorCalibration.JedecId = 0;
+  }
+}
+
+/**
+  Save the delay line calibration once variables are writable, unless the
+  stored copy already matches.
+
+  @param[in]    Event   The Event that is being processed
+  @param[in]    Context Event Context
+**/
+STATIC
+VOID
+EFIAPI
+NorVariableWriteNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_STATUS       Status;
+  VOID             *Interface;
+  UINTN            Size;
+  NOR_CALIBRATION  Cached;
+
+  Status = gBS->LocateProtocol (&gEfiVariableWriteArchProtocolGuid, NULL, &Interface);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  gBS->CloseEvent (Event);
+
+  Size   = sizeof (Cached);
+  Status = gRT->GetVariable (
+                  NOR_CALIB_VARIABLE_NAME,
+                  &gRockchipFspiCalibrationGuid,
+                  NULL,
+                  &Size,
+                  &Cached
+                  );
+  if (!EFI_ERROR (Status) && (Size == sizeof (Cached)) &&
+      (CompareMem (&Cached, &mNorCalibration, sizeof (Cached)) == 0))
+  {
+    return;
+  }
+
+  Status = gRT->SetVariable (
+                  NOR_CALIB_VARIABLE_NAME,
+                  &gRockchipFspiCalibrationGuid,
+                  EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                  sizeof (mNorCalibration),
+                  &mNorCalibration
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "%a: Failed to save calibration: %r\n", __FUNCTION__, Status));
+  }
+}
+
 EFI_STATUS
 EFIAPI
 InitializeFlash (
@@ -1359,7 +2187,8 @@ InitializeFlash (
   IN EFI_SYSTEM_TABLE  *SystemTable
   )
 {
-  EFI_STATUS  Status = RETURN_SUCCESS;
+  EFI_STATUS            Status = RETURN_SUCCESS;
+  EFI_PHYSICAL_ADDRESS  DmaBuffer;
 
   g_spi = AllocateRuntimeZeroPool (sizeof (struct HAL_FSPI_HOST));
   g_nor = AllocateRuntimeZeroPool (sizeof (struct SPI_NOR));
@@ -1371,12 +2200,43 @@ InitializeFlash (
   g_spi->instance = (struct FSPI_REG *)FixedPcdGet32 (FspiBaseAddr);
   g_spi->CruBase  = (UINT32 *)FixedPcdGet32 (CruBaseAddr);
 
+  InitializeSpinLock (&mNorLock);
+
   NorFspiIomux ();
   HAL_FSPI_Init (g_spi);
+
+  // FSPI DMA can only address the low 4 GiB
+  DmaBuffer = MAX_UINT32;
+  Status    = gBS->AllocatePages (
+                     AllocateMaxAddress,
+                     EfiBootServicesData,
+                     EFI_SIZE_TO_PAGES (NOR_DMA_BUFFER_SIZE),
+                     &DmaBuffer
+                     );
+  if (!EFI_ERROR (Status)) {
+    g_spi->dmaBuf     = (VOID *)(UINTN)DmaBuffer;
+    g_spi->dmaBufSize = NOR_DMA_BUFFER_SIZE;
+  } else {
+    DEBUG ((DEBUG_WARN, "%a: No DMA buffer, using PIO: %r\n", __FUNCTION__, Status));
+  }
+
   g_nor->spi        = g_spi;
   g_nor->spi->mode  = HAL_SPI_MODE_3;
   g_nor->spi->mode |= (HAL_SPI_TX_QUAD | HAL_SPI_RX_QUAD);
   Status            = HAL_SNOR_Init (g_nor);
+  if (Status == RETURN_SUCCESS) {
+    NorCalibrate ();
+  }
+
+  if (mNorCalibration.JedecId != 0) {
+    EfiCreateProtocolNotifyEvent (
+      &gEfiVariableWriteArchProtocolGuid,
+      TPL_CALLBACK,
+      NorVariableWriteNotify,
+      NULL,
+      &mNorVariableWriteRegistration
+      );
+  }
 
   Status = gBS->InstallProtocolInterface (
                   &ImageHandle,
@@ -1401,6 +2261,20 @@ InitializeFlash (
     goto ErrorSetMemAttr;
   }
 
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  NorExitBootServicesEvent,
+                  NULL,
+                  &gEfiEventExitBootServicesGuid,
+                  &mNorExitBootServicesEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: Failed to register ExitBootServices event\n", __FUNCTION__));
+    gBS->CloseEvent (mNorVirtualAddrChangeEvent);
+    goto ErrorSetMemAttr;
+  }
+
   return Status;
 ErrorSetMemAttr:
   gBS->UninstallProtocolInterface (
@@ -1409,6 +2283,10 @@ ErrorSetMemAttr:
          NULL
          );
 
+  if (g_spi->dmaBuf != NULL) {
+    gBS->FreePages ((UINTN)g_spi->dmaBuf, EFI_SIZE_TO_PAGES (g_spi->dmaBufSize));
+  }
+
   FreePool (g_nor);
   FreePool (g_spi);
 
@@ -47,6 +47,7 @@ STATIC FVB_RK_BOOT_DEVICE  mFvbSecondaryRkBootDevices[] = {
 };
 
 STATIC EFI_EVENT         mFvbVirtualAddrChangeEvent;
+STATIC EFI_EVENT         mFvbExitBootServicesEvent;
 STATIC FVB_DEVICE        *mFvbDevice;
 STATIC CONST FVB_DEVICE  mRkFvbFlashInstanceTemplate = {
   NULL,  // SpiFlashProtocol ... NEED TO BE FILLED
@@ -55,7 +56,7 @@ STATIC CONST FVB_DEVICE  mRkFvbFlashInstanceTemplate = {
 
   NULL,  // DiskDevice ... NEED TO BE FILLED
   0,     // DiskMediaId ... NEED TO BE FILLED
-  FALSE, // DiskDataInvalidated ... NEED TO BE FILLED
+  0,     // DiskDirtyBlocks
 
   NULL, // Handle ... NEED TO BE FILLED
 
@@ -675,6 +676,427 @@ FvbRead (
   return EFI_SUCCESS;
 }
 
+/**
+  Record which blocks of the NV data need to be synced to the disk.
+
+  One bit per block covers the whole FVB: 3 x 64 KiB in 4 KiB blocks is
+  48 blocks. The UINT64 mask can only track 64 blocks, so if the FVB is
+  made larger, any write past block 63 marks everything for syncing.
+
+  @param[in]  FlashInstance   The FVB device.
+  @param[in]  Lba             The starting block, relative to StartLba.
+  @param[in]  Offset          Offset into the starting block.
+  @param[in]  NumBytes        Number of bytes modified.
+**/
+STATIC
+VOID
+FvbMarkDiskDataDirty (
+  IN FVB_DEVICE  *FlashInstance,
+  IN EFI_LBA     Lba,
+  IN UINTN       Offset,
+  IN UINTN       NumBytes
+  )
+{
+  UINT64  Block;
+  UINT64  LastBlock;
+
+  if (NumBytes == 0) {
+    return;
+  }
+
+  Block     = FlashInstance->StartLba + Lba + Offset / FlashInstance->Media.BlockSize;
+  LastBlock = FlashInstance->StartLba + Lba + (Offset + NumBytes - 1) / FlashInstance->Media.BlockSize;
+
+  for ( ; Block <= LastBlock; Block++) {
+    if (Block >= 64) {
+      // Not representable, sync everything
+      FlashInstance->DiskDirtyBlocks = MAX_UINT64;
+      return;
+    }
+
+    FlashInstance->DiskDirtyBlocks |= LShiftU64 (1, (UINTN)Block);
+  }
+}
+
+//
+// Write-back queue for SPI flash writes.
+//
+// FTW and the variable driver issue many small writes per SetVariable,
+// each of which would otherwise cost a full NOR program-and-wait cycle.
+// Writes land in the shadow buffer immediately and are logged here in
+// issue order, with a write that continues the previous one merged into
+// it. The log is replayed with the data as it was written, so FTW sees
+// the same ordering on the flash as it would with synchronous writes.
+//
+// The queue is flushed when it fills up, before any erase, after a short
+// idle period, and at ExitBootServices and reset. The idle flush may
+// preempt another user of the NOR flash protocol (e.g. a capsule update),
+// in which case the protocol returns EFI_NOT_READY and the flush is tried
+// again later. Queueing stops at ReadyToBoot, so writes made by the shell,
+// boot loaders and at runtime reach the flash before the caller returns.
+//
+#define FVB_WRITE_QUEUE_ENTRIES    64
+#define FVB_WRITE_QUEUE_DATA_SIZE  SIZE_16KB
+#define FVB_WRITE_FLUSH_DELAY      EFI_TIMER_PERIOD_MILLISECONDS (10)
+#define FVB_WRITE_FLUSH_RETRIES    3
+
+typedef struct {
+  UINT32    FlashOffset;
+  UINT32    Length;
+  UINT32    DataOffset;
+} FVB_QUEUED_WRITE;
+
+STATIC FVB_QUEUED_WRITE  mFvbWriteQueue[FVB_WRITE_QUEUE_ENTRIES];
+STATIC UINTN             mFvbWriteQueueCount;
+STATIC UINT8             *mFvbWriteQueueData;
+STATIC UINTN             mFvbWriteQueueDataUsed;
+STATIC EFI_EVENT         mFvbWriteFlushEvent;
+STATIC BOOLEAN           mFvbWriteBackEnabled;
+
+/**
+  Program all queued writes to the SPI flash, in order.
+
+  Must be called at TPL_NOTIFY or above.
+
+  @param[in]  FlashInstance   The FVB device.
+
+  @retval EFI_SUCCESS   The queue is empty.
+  @retval Others        A write failed. It and the writes after it stay
+                        queued, so the next flush retries them.
+**/
+STATIC
+EFI_STATUS
+FvbFlushWrites (
+  IN FVB_DEVICE  *FlashInstance
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+
+  Status = EFI_SUCCESS;
+
+  for (Index = 0; Index < mFvbWriteQueueCount; Index++) {
+    Status = FlashInstance->SpiFlashProtocol->Write (
+                                                FlashInstance->SpiFlashProtocol,
+                                                mFvbWriteQueue[Index].FlashOffset,
+                                                mFvbWriteQueueData + mFvbWriteQueue[Index].DataOffset,
+                                                mFvbWriteQueue[Index].Length
+                                                );
+    if (EFI_ERROR (Status)) {
+      if (Status != EFI_NOT_READY) {
+        DEBUG ((DEBUG_ERROR, "%a: Failed to write to Spi device: %r\n", __FUNCTION__, Status));
+      }
+
+      CopyMem (
+        mFvbWriteQueue,
+        &mFvbWriteQueue[Index],
+        (mFvbWriteQueueCount - Index) * sizeof (FVB_QUEUED_WRITE)
+        );
+      mFvbWriteQueueCount -= Index;
+      return Status;
+    }
+  }
+
+  mFvbWriteQueueCount    = 0;
+  mFvbWriteQueueDataUsed = 0;
+
+  return Status;
+}
+
+/**
+  Flush the write-back queue once writes have been idle for
+  FVB_WRITE_FLUSH_DELAY. If the flash is in use by another caller, try
+  again after another delay. Other failures leave the writes queued for
+  the next flush.
+
+  @param[in]    Event   The Event that is being processed
+  @param[in]    Context Event Context
+**/
+STATIC
+VOID
+EFIAPI
+FvbWriteFlushEvent (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_STATUS  Status;
+  EFI_TPL     OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Status = FvbFlushWrites (mFvbDevice);
+  if (Status == EFI_NOT_READY) {
+    gBS->SetTimer (mFvbWriteFlushEvent, TimerRelative, FVB_WRITE_FLUSH_DELAY);
+  }
+
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Flush the write-back queue from an event that has no caller to report
+  a failure to, retrying a few times before giving up on the writes.
+
+  Must be called at TPL_NOTIFY or above.
+**/
+STATIC
+VOID
+FvbFlushWritesFromEvent (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Retry;
+
+  Status = EFI_SUCCESS;
+  for (Retry = 0; Retry < FVB_WRITE_FLUSH_RETRIES; Retry++) {
+    Status = FvbFlushWrites (mFvbDevice);
+    if (!EFI_ERROR (Status)) {
+      return;
+    }
+  }
+
+  DEBUG ((
+    DEBUG_ERROR,
+    "%a: %u queued variable store writes lost: %r\n",
+    __FUNCTION__,
+    (UINT32)mFvbWriteQueueCount,
+    Status
+    ));
+  mFvbWriteQueueCount    = 0;
+  mFvbWriteQueueDataUsed = 0;
+}
+
+/**
+  Write to the SPI flash, through the write-back queue when it is enabled.
+
+  @param[in]  FlashInstance   The FVB device.
+  @param[in]  FlashOffset     Offset in the SPI flash.
+  @param[in]  Buffer          The data to write.
+  @param[in]  Length          Number of bytes to write.
+**/
+STATIC
+EFI_STATUS
+FvbQueueWrite (
+  IN FVB_DEVICE  *FlashInstance,
+  IN UINTN       FlashOffset,
+  IN UINT8       *Buffer,
+  IN UINTN       Length
+  )
+{
+  EFI_STATUS        Status;
+  EFI_TPL           OldTpl;
+  FVB_QUEUED_WRITE  *Last;
+
+  if (!mFvbWriteBackEnabled || EfiAtRuntime () || (Length > FVB_WRITE_QUEUE_DATA_SIZE)) {
+    if (!EfiAtRuntime ()) {
+      OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+      Status = FvbFlushWrites (FlashInstance);
+      gBS->RestoreTPL (OldTpl);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+
+    return FlashInstance->SpiFlashProtocol->Write (
+                                              FlashInstance->SpiFlashProtocol,
+                                              FlashOffset,
+                                              Buffer,
+                                              Length
+                                              );
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Status = EFI_SUCCESS;
+
+  Last = (mFvbWriteQueueCount > 0) ? &mFvbWriteQueue[mFvbWriteQueueCount - 1] : NULL;
+  if ((Last != NULL) &&
+      (Last->FlashOffset + Last->Length == FlashOffset) &&
+      (Last->DataOffset + Last->Length == mFvbWriteQueueDataUsed) &&
+      (mFvbWriteQueueDataUsed + Length <= FVB_WRITE_QUEUE_DATA_SIZE))
+  {
+    // Continues the previous write
+    Last->Length += (UINT32)Length;
+  } else {
+    if ((mFvbWriteQueueCount == FVB_WRITE_QUEUE_ENTRIES) ||
+        (mFvbWriteQueueDataUsed + Length > FVB_WRITE_QUEUE_DATA_SIZE))
+    {
+      //
+      // Don't queue the write if there is no room for it, the caller
+      // won't update the shadow buffer either.
+      //
+      Status = FvbFlushWrites (FlashInstance);
+      if (EFI_ERROR (Status)) {
+        gBS->RestoreTPL (OldTpl);
+        return Status;
+      }
+    }
+
+    mFvbWriteQueue[mFvbWriteQueueCount].FlashOffset = (UINT32)FlashOffset;
+    mFvbWriteQueue[mFvbWriteQueueCount].Length      = (UINT32)Length;
+    mFvbWriteQueue[mFvbWriteQueueCount].DataOffset  = (UINT32)mFvbWriteQueueDataUsed;
+    mFvbWriteQueueCount++;
+  }
+
+  CopyMem (mFvbWriteQueueData + mFvbWriteQueueDataUsed, Buffer, Length);
+  mFvbWriteQueueDataUsed += Length;
+
+  gBS->SetTimer (mFvbWriteFlushEvent, TimerRelative, FVB_WRITE_FLUSH_DELAY);
+
+  gBS->RestoreTPL (OldTpl);
+
+  return Status;
+}
+
+/**
+  Flush the write-back queue and stop queueing, as runtime writes must
+  reach the flash before the caller returns.
+
+  @param[in]    Event   The Event that is being processed
+  @param[in]    Context Event Context
+**/
+STATIC
+VOID
+EFIAPI
+FvbExitBootServicesEvent (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  gBS->SetTimer (mFvbWriteFlushEvent, TimerCancel, 0);
+  FvbFlushWritesFromEvent ();
+  mFvbWriteBackEnabled = FALSE;
+}
+
+/**
+  Flush the write-back queue and stop queueing. Anything set from here
+  on (boot options, BootNext, shell variables) is written synchronously.
+
+  @param[in]    Event   The Event that is being processed
+  @param[in]    Context Event Context
+**/
+STATIC
+VOID
+EFIAPI
+FvbFlushWritesReadyToBootEvent (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_TPL  OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  gBS->SetTimer (mFvbWriteFlushEvent, TimerCancel, 0);
+  FvbFlushWritesFromEvent ();
+  mFvbWriteBackEnabled = FALSE;
+  gBS->RestoreTPL (OldTpl);
+}
+
+STATIC
+VOID
+EFIAPI
+FvbFlushWritesResetHandler (
+  IN EFI_RESET_TYPE  ResetType,
+  IN EFI_STATUS      ResetStatus,
+  IN UINTN           DataSize,
+  IN VOID            *ResetData OPTIONAL
+  )
+{
+  EFI_TPL  OldTpl;
+
+  if (!mFvbWriteBackEnabled) {
+    return;
+  }
+
+  // ResetSystem () may be called at up to TPL_HIGH_LEVEL
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  FvbFlushWritesFromEvent ();
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Set up the write-back queue. SPI writes stay synchronous if this fails.
+**/
+STATIC
+VOID
+FvbInstallWriteBackQueue (
+  VOID
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_RESET_NOTIFICATION_PROTOCOL  *ResetNotify;
+  EFI_EVENT                        ReadyToBootEvent;
+
+  mFvbWriteQueueData = AllocatePool (FVB_WRITE_QUEUE_DATA_SIZE);
+  if (mFvbWriteQueueData == NULL) {
+    return;
+  }
+
+  Status = gBS->LocateProtocol (
+                  &gEfiResetNotificationProtocolGuid,
+                  NULL,
+                  (VOID **)&ResetNotify
+                  );
+  if (!EFI_ERROR (Status)) {
+    Status = ResetNotify->RegisterResetNotify (
+                            ResetNotify,
+                            FvbFlushWritesResetHandler
+                            );
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "%a: No reset notification, writes stay synchronous\n", __FUNCTION__));
+    goto Error;
+  }
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  FvbWriteFlushEvent,
+                  NULL,
+                  &mFvbWriteFlushEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    goto ErrorUnregisterReset;
+  }
+
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_NOTIFY,
+                  FvbExitBootServicesEvent,
+                  NULL,
+                  &gEfiEventExitBootServicesGuid,
+                  &mFvbExitBootServicesEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    goto ErrorCloseTimer;
+  }
+
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  FvbFlushWritesReadyToBootEvent,
+                  NULL,
+                  &gEfiEventReadyToBootGuid,
+                  &ReadyToBootEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    goto ErrorCloseExitBootServices;
+  }
+
+  mFvbWriteBackEnabled = TRUE;
+  return;
+
+ErrorCloseExitBootServices:
+  gBS->CloseEvent (mFvbExitBootServicesEvent);
+ErrorCloseTimer:
+  gBS->CloseEvent (mFvbWriteFlushEvent);
+ErrorUnregisterReset:
+  ResetNotify->UnregisterResetNotify (ResetNotify, FvbFlushWritesResetHandler);
+Error:
+  FreePool (mFvbWriteQueueData);
+  mFvbWriteQueueData = NULL;
+}
+
 /**
  Writes the specified number of bytes from the input buffer to the block.
 
@@ -756,12 +1178,7 @@ FvbWrite (
                  );
 
   if (FlashInstance->IsSpiFlashAvailable) {
-    Status = FlashInstance->SpiFlashProtocol->Write (
-                                                FlashInstance->SpiFlashProtocol,
-                                                DataOffset,
-                                                Buffer,
-                                                *NumBytes
-                                                );
+    Status = FvbQueueWrite (FlashInstance, DataOffset, Buffer, *NumBytes);
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "%a: Failed to write to Spi device\n", __FUNCTION__));
       return Status;
@@ -778,7 +1195,7 @@ FvbWrite (
   CopyMem ((UINTN *)DataOffset, Buffer, *NumBytes);
 
   // Must sync the data if it's on a disk
-  FlashInstance->DiskDataInvalidated = TRUE;
+  FvbMarkDiskDataDirty (FlashInstance, Lba, Offset, *NumBytes);
 
   return EFI_SUCCESS;
 }
@@ -843,6 +1260,7 @@ FvbEraseBlocks (
   UINTN                 BlockAddress;  // Physical address of Lba to erase
   EFI_LBA               StartingLba;   // Lba from which we start erasing
   UINTN                 NumOfLba;      // Number of Lba blocks to erase
+  EFI_TPL               OldTpl;
 
   FlashInstance = INSTANCE_FROM_FVB_THIS (This);
 
@@ -899,6 +1317,19 @@ FvbEraseBlocks (
 
   VA_END (Args);
 
+  //
+  // Queued writes must reach the flash before anything is erased,
+  // both for ordering and because they may target the erased blocks.
+  //
+  if (FlashInstance->IsSpiFlashAvailable && !EfiAtRuntime ()) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    Status = FvbFlushWrites (FlashInstance);
+    gBS->RestoreTPL (OldTpl);
+    if (EFI_ERROR (Status)) {
+      return EFI_DEVICE_ERROR;
+    }
+  }
+
   //
   // Start erasing
   //
@@ -947,7 +1378,7 @@ FvbEraseBlocks (
       SetMem ((UINTN *)BlockAddress, FlashInstance->Media.BlockSize, 0xFF);
 
       // Must sync the data if it's on a disk
-      FlashInstance->DiskDataInvalidated = TRUE;
+      FvbMarkDiskDataDirty (FlashInstance, StartingLba, 0, FlashInstance->Media.BlockSize);
 
       // Move to the next Lba
       StartingLba++;
@@ -1151,17 +1582,31 @@ FvbConfigureFlashInstance (
   return Status;
 }
 
+/**
+  Write NV data blocks from memory to the disk, coalescing adjacent
+  blocks into a single write.
+
+  @param[in]  Device      The disk device path.
+  @param[in]  MediaId     The disk media ID.
+  @param[in]  BlockMask   The blocks to write, one bit per block.
+**/
 STATIC
 EFI_STATUS
 FvbDiskDumpNvData (
   IN EFI_DEVICE_PATH_PROTOCOL  *Device,
-  IN UINT32                    MediaId
+  IN UINT32                    MediaId,
+  IN UINT64                    BlockMask
   )
 {
   EFI_STATUS            Status;
   EFI_DISK_IO_PROTOCOL  *DiskIo = NULL;
   EFI_HANDLE            Handle;
   UINTN                 DataOffset;
+  UINTN                 BlockSize;
+  UINTN                 NumBlocks;
+  UINTN                 Block;
+  UINTN                 EndBlock;
+  UINTN                 Length;
 
   Status = gBS->LocateDevicePath (&gEfiDiskIoProtocolGuid, &Device, &Handle);
   if (EFI_ERROR (Status)) {
@@ -1179,15 +1624,33 @@ FvbDiskDumpNvData (
                  mFvbDevice->Media.BlockSize
                  );
 
-  Status = DiskIo->WriteDisk (
-                     DiskIo,
-                     MediaId,
-                     DataOffset,
-                     mFvbDevice->FvbSize,
-                     (VOID *)mFvbDevice->FvbOffset
-                     );
+  BlockSize = mFvbDevice->Media.BlockSize;
+  NumBlocks = MIN (ALIGN_VALUE (mFvbDevice->FvbSize, BlockSize) / BlockSize, 64);
 
-  return Status;
+  for (Block = 0; Block < NumBlocks; Block = EndBlock) {
+    EndBlock = Block + 1;
+    if ((BlockMask & LShiftU64 (1, Block)) == 0) {
+      continue;
+    }
+
+    while ((EndBlock < NumBlocks) && (BlockMask & LShiftU64 (1, EndBlock))) {
+      EndBlock++;
+    }
+
+    Length = MIN (EndBlock * BlockSize, mFvbDevice->FvbSize) - Block * BlockSize;
+    Status = DiskIo->WriteDisk (
+                       DiskIo,
+                       MediaId,
+                       DataOffset + Block * BlockSize,
+                       Length,
+                       (VOID *)(mFvbDevice->FvbOffset + Block * BlockSize)
+                       );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
 }
 
 STATIC
@@ -1203,11 +1666,15 @@ FvbDiskNvDumpHandler (
     return;
   }
 
-  if (!mFvbDevice->DiskDataInvalidated) {
+  if (mFvbDevice->DiskDirtyBlocks == 0) {
     return;
   }
 
-  Status = FvbDiskDumpNvData (mFvbDevice->DiskDevice, mFvbDevice->DiskMediaId);
+  Status = FvbDiskDumpNvData (
+             mFvbDevice->DiskDevice,
+             mFvbDevice->DiskMediaId,
+             mFvbDevice->DiskDirtyBlocks
+             );
   if (EFI_ERROR (Status)) {
     CHAR16  *DevicePathText = ConvertDevicePathToText (mFvbDevice->DiskDevice, FALSE, FALSE);
     DEBUG ((
@@ -1226,7 +1693,7 @@ FvbDiskNvDumpHandler (
 
   DEBUG ((DEBUG_INFO, "NV data dumped!\n"));
 
-  mFvbDevice->DiskDataInvalidated = FALSE;
+  mFvbDevice->DiskDirtyBlocks = 0;
 }
 
 STATIC
@@ -1480,7 +1947,7 @@ FvbProcessBootDiskDeviceHandle (
     goto Exit;
   }
 
-  Status = FvbDiskDumpNvData (Device, BlkIo->Media->MediaId);
+  Status = FvbDiskDumpNvData (Device, BlkIo->Media->MediaId, MAX_UINT64);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "%a: [%s] Couldn't update NV data!\n", __FUNCTION__, DevicePathText));
     ASSERT_EFI_ERROR (Status);
@@ -1489,8 +1956,9 @@ FvbProcessBootDiskDeviceHandle (
 
   DEBUG ((DEBUG_INFO, "%a: [%s] Found boot disk for NV storage!\n", __FUNCTION__, DevicePathText));
 
-  mFvbDevice->DiskDevice  = Device;
-  mFvbDevice->DiskMediaId = BlkIo->Media->MediaId;
+  mFvbDevice->DiskDevice      = Device;
+  mFvbDevice->DiskMediaId     = BlkIo->Media->MediaId;
+  mFvbDevice->DiskDirtyBlocks = 0;
 
 Exit:
   if ((Device != NULL) && (mFvbDevice->DiskDevice != Device)) {
@@ -1729,6 +2197,8 @@ RkFvbEntryPoint (
   if (!mFvbDevice->IsSpiFlashAvailable) {
     FvbInstallDiskNotifyHandler ();
     FvbInstallDiskNvDumpEventHandlers ();
+  } else {
+    FvbInstallWriteBackQueue ();
   }
 
   return Status;
@@ -47,7 +47,7 @@ typedef struct {
 
   EFI_DEVICE_PATH_PROTOCOL               *DiskDevice;
   UINT32                                 DiskMediaId;
-  BOOLEAN                                DiskDataInvalidated;
+  UINT64                                 DiskDirtyBlocks;
 
   EFI_HANDLE                             Handle;
 
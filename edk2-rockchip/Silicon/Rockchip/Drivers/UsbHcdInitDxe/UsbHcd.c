@@ -12,6 +12,7 @@
 #include <Library/DebugLib.h>
 #include <Library/IoLib.h>
 #include <Library/NonDiscoverableDeviceRegistrationLib.h>
+#include <Library/PerformanceLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/RockchipPlatformLib.h>
 #include <Library/MemoryAllocationLib.h>
@@ -343,6 +344,8 @@ UsbEndOfDxeCallback (
 
   gBS->CloseEvent (Event);
 
+  PERF_INMODULE_BEGIN ("UsbEndOfDxe");
+
   XhciControllerAddrArrayPtr  = PcdGetPtr (PcdDwc3BaseAddresses);
   XhciControllerAddrArraySize = PcdGetSize (PcdDwc3BaseAddresses);
 
@@ -421,6 +424,8 @@ UsbEndOfDxeCallback (
         ));
     }
   }
+
+  PERF_INMODULE_END ("UsbEndOfDxe");
 }
 
 /**
@@ -0,0 +1,45 @@
+/** @file
+
+  In-memory debug log, installed as a configuration table by DebugLogDxe.
+
+  Data is a ring of Size bytes. Head counts all bytes ever logged, so the
+  most recent MIN (Head, Size) bytes end at Data[Head % Size]. Tail counts
+  the bytes already sent to the serial port.
+
+  Head, Tail and Busy are only changed at TPL_NOTIFY, or above it while
+  Busy is clear.
+
+  Copyright (c) 2025, Mario Bălănică <mariobalanica02@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef DEBUG_LOG_TABLE_H_
+#define DEBUG_LOG_TABLE_H_
+
+#define ROCKCHIP_DEBUG_LOG_TABLE_GUID \
+  { 0x3e4b6a2d, 0x7c51, 0x4f0e, { 0x9a, 0x83, 0x2b, 0xd1, 0x6e, 0x45, 0xc9, 0x07 } }
+
+#define ROCKCHIP_DEBUG_LOG_TABLE_SIGNATURE  SIGNATURE_32 ('R', 'K', 'L', 'G')
+
+typedef struct {
+  UINT32    Signature;
+  UINT32    Size;
+  UINT64    Head;
+  UINT64    Tail;
+  //
+  // Non-zero while writers may leave output for the drain timer.
+  //
+  UINT32    Active;
+  //
+  // Non-zero while a writer or the drain timer is updating Head or Tail,
+  // so that code preempting it at TPL_HIGH_LEVEL leaves the ring alone.
+  //
+  UINT32    Busy;
+  // UINT8  Data[Size];
+} ROCKCHIP_DEBUG_LOG_TABLE;
+
+extern EFI_GUID  gRockchipDebugLogTableGuid;
+
+#endif // DEBUG_LOG_TABLE_H_
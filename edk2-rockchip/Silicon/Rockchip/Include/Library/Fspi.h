@@ -9,6 +9,7 @@
 
 #define HAL_FSPI_QUAD_ENABLE
 #define HAL_FSPI_SPEED_THRESHOLD  100000000
+#define HAL_FSPI_DMA_THRESHOLD    512
 
 /***************************** Structure Definition **************************/
 /** FSPI_CTRL register datalines, addrlines and cmdlines value */
@@ -77,6 +78,8 @@ struct HAL_FSPI_HOST {
   UINT8              cs;   /**< Should be defined by user in each operation */
   UINT8              mode; /**< Should be defined by user, referring to hal_spi_mem.h */
   UINT8              cell; /**< Record DLL cell for PM resume, Set depend on corresponding device */
+  void               *dmaBuf;    /**< 32-bit addressable bounce buffer, NULL to disable DMA */
+  UINT32             dmaBufSize; /**< Size of dmaBuf, limits unaligned DMA transfers */
 };
 
 #define HAL_FSPI_MAX_DELAY_LINE_CELLS  (0xFFU)
@@ -83,6 +83,8 @@ struct SPI_NOR {
   UINT32                     size;
   UINT32                     sectorSize;
   UINT32                     eraseSize;
+  UINT32                     eraseTimeoutMs[3]; /**< Max sector, 64K block and chip erase time */
+  UINT32                     progTimeoutUs;     /**< Max page program time */
 };
 
 typedef enum {
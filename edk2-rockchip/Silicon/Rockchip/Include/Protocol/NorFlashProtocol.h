@@ -55,6 +55,11 @@ EFI_STATUS
   UINT32                   ulLength
   );
 
+//
+// Erase, Write, Read and Update are not reentrant. A call made while
+// another one is in progress, which can only happen from an event that
+// preempted it, returns EFI_NOT_READY without touching the flash.
+//
 struct _UNI_NOR_FLASH_PROTOCOL {
   UNI_FLASH_GET_SIZE_INTERFACE    GetSize;
   UNI_FLASH_ERASE_INTERFACE       Erase;
@@ -25,8 +25,10 @@
 #define UART_IIR_REG  (SERIAL_0_BASE_ADR + UART_IIR)
 #define UART_FCR_REG  (SERIAL_0_BASE_ADR + UART_FCR)
 #define UART_LCR_REG  (SERIAL_0_BASE_ADR + UART_LCR)
+#define UART_MCR_REG  (SERIAL_0_BASE_ADR + UART_MCR)
 #define UART_LSR_REG  (SERIAL_0_BASE_ADR + UART_LSR)
 #define UART_USR_REG  (SERIAL_0_BASE_ADR + UART_USR)
+#define UART_TFL_REG  (SERIAL_0_BASE_ADR + UART_TFL)
 
 #define UART_RBR  0x00
 #define UART_THR  0x00
@@ -39,6 +41,7 @@
 #define UART_MCR  0x10
 #define UART_LSR  0x14
 #define UART_USR  0x7C
+#define UART_TFL  0x80
 
 /* register definitions */
 
@@ -67,6 +70,11 @@
 
 #define UART_DLH_AND_DLL_WIDTH  0xFF
 
+/*MCR Name: Modem Control Register fields*/
+#define UART_MCR_DTR   0x01
+#define UART_MCR_RTS   0x02
+#define UART_MCR_LOOP  0x10
+
 #define UART_IER_PTIME  0x80
 #define UART_IER_ELSI   0x04
 #define UART_IER_ETBEI  0x02
@@ -91,8 +99,10 @@
 #define UART_LSR_DR    0x01
 
 #define UART_USR_BUSY  0x01
+#define UART_USR_TFNF  0x02
+#define UART_USR_TFE   0x04
 
-#define FIFO_MAXSIZE  32
+#define FIFO_MAXSIZE  64
 
 extern UINT8
 SerialPortReadChar (
@@ -104,4 +114,15 @@ SerialPortWriteChar (
   UINT8  scShowChar
   );
 
+extern VOID
+SerialPortFlushTx (
+  VOID
+  );
+
+extern VOID
+SerialPortWriteFifo (
+  IN UINT8  *Buffer,
+  IN UINTN  NumberOfBytes
+  );
+
 #endif
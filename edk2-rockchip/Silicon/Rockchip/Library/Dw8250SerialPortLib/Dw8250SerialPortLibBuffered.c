@@ -0,0 +1,210 @@
+/** @file
+  UART Serial Port library functions, buffered through the DXE debug log
+
+  Once DebugLogDxe has installed the debug log table, writes made below
+  TPL_NOTIFY are copied into its ring and sent out from the driver's
+  TPL_NOTIFY timer event. Code that stops below TPL_NOTIFY, such as the
+  CpuDeadLoop () after a failed ASSERT, leaves that timer running, so
+  what it printed still reaches the UART.
+
+  Everything else is written to the UART directly, after sending out
+  what is buffered when the ring is not in use:
+  - at or above TPL_NOTIFY, or with interrupts masked (e.g. exception
+    handlers), where the timer cannot run until the TPL drops again;
+  - zero-length writes, which flush the ring and the UART;
+  - before the table exists and after ExitBootServices.
+
+  Copyright (c) 2025, Mario Bălănică <mariobalanica02@gmail.com>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/PcdLib.h>
+#include <Library/SerialPortLib.h>
+#include <Library/IoLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Guid/DebugLogTable.h>
+
+#include "Dw8250SerialPortLib.h"
+
+STATIC ROCKCHIP_DEBUG_LOG_TABLE  *mDebugLog;
+
+STATIC
+ROCKCHIP_DEBUG_LOG_TABLE *
+GetDebugLog (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  //
+  // gST is set up by the UefiBootServicesTableLib constructor, which may
+  // run after DebugLib's constructor has already printed something.
+  //
+  if ((mDebugLog != NULL) || (gST == NULL)) {
+    return mDebugLog;
+  }
+
+  for (Index = 0; Index < gST->NumberOfTableEntries; Index++) {
+    if (CompareGuid (&gST->ConfigurationTable[Index].VendorGuid, &gRockchipDebugLogTableGuid)) {
+      mDebugLog = gST->ConfigurationTable[Index].VendorTable;
+      break;
+    }
+  }
+
+  return mDebugLog;
+}
+
+/**
+  Send the logged data up to Limit to the serial port, waiting for room in
+  the FIFO as needed.
+  The caller must hold the log exclusively.
+**/
+STATIC
+VOID
+DebugLogDrain (
+  IN ROCKCHIP_DEBUG_LOG_TABLE  *Log,
+  IN UINT64                    Limit
+  )
+{
+  UINT8  *Data;
+  UINTN  Offset;
+  UINTN  Length;
+
+  Data = (UINT8 *)(Log + 1);
+
+  while (Log->Tail < Limit) {
+    Offset = ModU64x32 (Log->Tail, Log->Size);
+    Length = (UINTN)MIN (Limit - Log->Tail, Log->Size - Offset);
+    SerialPortWriteFifo (Data + Offset, Length);
+    Log->Tail += Length;
+  }
+}
+
+/**
+  Copy data into the log. When it is full, only as much of the oldest
+  data as is needed to make room is sent out synchronously.
+  The caller must hold the log exclusively.
+**/
+STATIC
+VOID
+DebugLogAppend (
+  IN ROCKCHIP_DEBUG_LOG_TABLE  *Log,
+  IN UINT8                     *Buffer,
+  IN UINTN                     NumberOfBytes
+  )
+{
+  UINT8  *Data;
+  UINTN  Offset;
+  UINTN  Length;
+
+  Data = (UINT8 *)(Log + 1);
+
+  while (NumberOfBytes > 0) {
+    if (Log->Head - Log->Tail >= Log->Size) {
+      DebugLogDrain (Log, Log->Tail + MIN (NumberOfBytes, Log->Size));
+    }
+
+    Offset = ModU64x32 (Log->Head, Log->Size);
+    Length = (UINTN)(Log->Size - (Log->Head - Log->Tail));
+    Length = MIN (Length, Log->Size - Offset);
+    Length = MIN (Length, NumberOfBytes);
+
+    CopyMem (Data + Offset, Buffer, Length);
+    Log->Head     += Length;
+    Buffer        += Length;
+    NumberOfBytes -= Length;
+  }
+}
+
+/**
+  Write data from buffer to serial device.
+
+  Writes NumberOfBytes data bytes from Buffer to the serial device.
+  The number of bytes actually written to the serial device is returned.
+  If the return value is less than NumberOfBytes, then the write operation failed.
+
+  If Buffer is NULL, then ASSERT().
+
+  If NumberOfBytes is zero, then send out any buffered data, wait for the
+  transmitter to drain and return 0.
+
+  @param  Buffer           Pointer to the data buffer to be written.
+  @param  NumberOfBytes    Number of bytes to written to the serial device.
+
+  @retval 0                NumberOfBytes is 0.
+  @retval >0               The number of bytes written to the serial device.
+                           If this value is less than NumberOfBytes, then the read operation failed.
+
+**/
+UINTN
+EFIAPI
+SerialPortWrite (
+  IN UINT8  *Buffer,
+  IN UINTN  NumberOfBytes
+  )
+{
+  ROCKCHIP_DEBUG_LOG_TABLE  *Log;
+  EFI_TPL                   OldTpl;
+
+  if (NULL == Buffer) {
+    return 0;
+  }
+
+  Log = GetDebugLog ();
+  if ((Log == NULL) || !Log->Active) {
+    if (NumberOfBytes == 0) {
+      SerialPortFlushTx ();
+    } else {
+      SerialPortWriteFifo (Buffer, NumberOfBytes);
+    }
+
+    return NumberOfBytes;
+  }
+
+  //
+  // Find the current TPL. With interrupts masked, restoring it would
+  // unmask them, so treat that as TPL_HIGH_LEVEL.
+  //
+  if (GetInterruptState ()) {
+    OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+    gBS->RestoreTPL (OldTpl);
+  } else {
+    OldTpl = TPL_HIGH_LEVEL;
+  }
+
+  if (OldTpl >= TPL_NOTIFY) {
+    //
+    // The timer can't drain the ring from here, so write synchronously.
+    // Above TPL_NOTIFY this may have preempted an owner of the ring, in
+    // which case the ring is left alone and this output overtakes it.
+    //
+    if (!Log->Busy) {
+      DebugLogDrain (Log, Log->Head);
+    }
+
+    if (NumberOfBytes == 0) {
+      SerialPortFlushTx ();
+    } else {
+      SerialPortWriteFifo (Buffer, NumberOfBytes);
+    }
+
+    return NumberOfBytes;
+  }
+
+  OldTpl    = gBS->RaiseTPL (TPL_NOTIFY);
+  Log->Busy = 1;
+
+  if (NumberOfBytes == 0) {
+    DebugLogDrain (Log, Log->Head);
+    SerialPortFlushTx ();
+  } else {
+    DebugLogAppend (Log, Buffer, NumberOfBytes);
+  }
+
+  Log->Busy = 0;
+  gBS->RestoreTPL (OldTpl);
+
+  return NumberOfBytes;
+}
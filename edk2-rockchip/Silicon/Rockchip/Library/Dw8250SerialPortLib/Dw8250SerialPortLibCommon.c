@@ -17,45 +17,47 @@
 #include "Dw8250SerialPortLib.h"
 
 /**
-  Write data from buffer to serial device.
+  Write data to the TX FIFO, waiting for free space as needed.
 
-  Writes NumberOfBytes data bytes from Buffer to the serial device.
-  The number of bytes actually written to the serial device is returned.
-  If the return value is less than NumberOfBytes, then the write operation failed.
-
-  If Buffer is NULL, then ASSERT().
-
-  If NumberOfBytes is zero, then return 0.
+  The FIFO is filled up to its free depth instead of waiting for each
+  character to leave the shift register.
 
   @param  Buffer           Pointer to the data buffer to be written.
   @param  NumberOfBytes    Number of bytes to written to the serial device.
 
-  @retval 0                NumberOfBytes is 0.
-  @retval >0               The number of bytes written to the serial device.
-                           If this value is less than NumberOfBytes, then the read operation failed.
-
 **/
-UINTN
-EFIAPI
-SerialPortWrite (
+VOID
+SerialPortWriteFifo (
   IN UINT8  *Buffer,
   IN UINTN  NumberOfBytes
   )
 {
-  UINTN  Result;
+  UINTN   Free;
+  UINT32  ulLoop;
 
-  if (NULL == Buffer) {
-    return 0;
-  }
+  while (NumberOfBytes > 0) {
+    ulLoop = 0;
+    do {
+      Free = FIFO_MAXSIZE - MIN (MmioRead32 (UART_TFL_REG), FIFO_MAXSIZE);
+      if (Free > 0) {
+        break;
+      }
 
-  Result = NumberOfBytes;
+      ulLoop++;
+    } while (ulLoop < (UINT32)UART_SEND_DELAY);
 
-  while (NumberOfBytes--) {
-    SerialPortWriteChar (*Buffer);
-    Buffer++;
-  }
+    //
+    // On timeout, push one character anyway, as SerialPortWriteChar does.
+    //
+    Free = MAX (Free, 1);
+    Free = MIN (Free, NumberOfBytes);
 
-  return Result;
+    NumberOfBytes -= Free;
+    while (Free--) {
+      MmioWrite8 (UART_THR_REG, *Buffer);
+      Buffer++;
+    }
+  }
 }
 
 /**
@@ -124,7 +126,7 @@ SerialPortWriteChar (
   UINT32  ulLoop = 0;
 
   while (ulLoop < (UINT32)UART_SEND_DELAY) {
-    if ((MmioRead8 (UART_USR_REG) & 0x02) == 0x02) {
+    if ((MmioRead8 (UART_USR_REG) & UART_USR_TFNF) == UART_USR_TFNF) {
       break;
     }
 
@@ -133,16 +135,28 @@ SerialPortWriteChar (
 
   MmioWrite8 (UART_THR_REG, (UINT8)scShowChar);
 
-  ulLoop = 0;
+  return;
+}
+
+/**
+  Wait until the TX FIFO and the transmit shift register are empty.
+**/
+VOID
+SerialPortFlushTx (
+  VOID
+  )
+{
+  UINT32  ulLoop = 0;
+
   while (ulLoop < (UINT32)UART_SEND_DELAY) {
-    if ((MmioRead8 (UART_USR_REG) & 0x04) == 0x04) {
+    if (((MmioRead8 (UART_USR_REG) & (UART_USR_TFE | UART_USR_BUSY)) == UART_USR_TFE) &&
+        ((MmioRead8 (UART_LSR_REG) & UART_LSR_TEMT) == UART_LSR_TEMT))
+    {
       break;
     }
 
     ulLoop++;
   }
-
-  return;
 }
 
 UINT8
@@ -226,7 +240,36 @@ SerialPortSetControl (
   IN UINT32  Control
   )
 {
-  return EFI_UNSUPPORTED;
+  UINT8  Mcr;
+
+  if ((Control & ~(EFI_SERIAL_REQUEST_TO_SEND | EFI_SERIAL_DATA_TERMINAL_READY |
+                   EFI_SERIAL_HARDWARE_LOOPBACK_ENABLE)) != 0)
+  {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Let pending output leave the FIFO before the modem lines change.
+  //
+  SerialPortFlushTx ();
+
+  Mcr = MmioRead8 (UART_MCR_REG) & ~(UART_MCR_DTR | UART_MCR_RTS | UART_MCR_LOOP);
+
+  if ((Control & EFI_SERIAL_REQUEST_TO_SEND) != 0) {
+    Mcr |= UART_MCR_RTS;
+  }
+
+  if ((Control & EFI_SERIAL_DATA_TERMINAL_READY) != 0) {
+    Mcr |= UART_MCR_DTR;
+  }
+
+  if ((Control & EFI_SERIAL_HARDWARE_LOOPBACK_ENABLE) != 0) {
+    Mcr |= UART_MCR_LOOP;
+  }
+
+  MmioWrite8 (UART_MCR_REG, Mcr);
+
+  return EFI_SUCCESS;
 }
 
 /**
@@ -244,11 +287,31 @@ SerialPortGetControl (
   OUT UINT32  *Control
   )
 {
-  if (SerialPortPoll ()) {
+  UINT8  Mcr;
+
+  *Control = 0;
+
+  if (!SerialPortPoll ()) {
     // If a character is pending don't set EFI_SERIAL_INPUT_BUFFER_EMPTY
-    *Control = EFI_SERIAL_OUTPUT_BUFFER_EMPTY;
-  } else {
-    *Control = EFI_SERIAL_INPUT_BUFFER_EMPTY | EFI_SERIAL_OUTPUT_BUFFER_EMPTY;
+    *Control |= EFI_SERIAL_INPUT_BUFFER_EMPTY;
+  }
+
+  // Output is buffered in the TX FIFO, only report empty once it drained
+  if ((MmioRead8 (UART_USR_REG) & UART_USR_TFE) == UART_USR_TFE) {
+    *Control |= EFI_SERIAL_OUTPUT_BUFFER_EMPTY;
+  }
+
+  Mcr = MmioRead8 (UART_MCR_REG);
+  if ((Mcr & UART_MCR_RTS) != 0) {
+    *Control |= EFI_SERIAL_REQUEST_TO_SEND;
+  }
+
+  if ((Mcr & UART_MCR_DTR) != 0) {
+    *Control |= EFI_SERIAL_DATA_TERMINAL_READY;
+  }
+
+  if ((Mcr & UART_MCR_LOOP) != 0) {
+    *Control |= EFI_SERIAL_HARDWARE_LOOPBACK_ENABLE;
   }
 
   return EFI_SUCCESS;
@@ -0,0 +1,56 @@
+/** @file
+  UART Serial Port library functions
+
+  Copyright (c) 2006 - 2009, Intel Corporation
+  Copyright (c) 2015 - 2016, Hisilicon Limited. All rights reserved.
+  Copyright (c) 2015 - 2016, Linaro Limited. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+  Based on the files under ArmPlatformPkg/Library/PL011SerialPortLib/
+**/
+#include <Uefi.h>
+#include <Library/PcdLib.h>
+#include <Library/SerialPortLib.h>
+#include <Library/IoLib.h>
+
+#include "Dw8250SerialPortLib.h"
+
+/**
+  Write data from buffer to serial device.
+
+  Writes NumberOfBytes data bytes from Buffer to the serial device.
+  The number of bytes actually written to the serial device is returned.
+  If the return value is less than NumberOfBytes, then the write operation failed.
+
+  If Buffer is NULL, then ASSERT().
+
+  If NumberOfBytes is zero, then wait for the transmitter to drain and return 0.
+
+  @param  Buffer           Pointer to the data buffer to be written.
+  @param  NumberOfBytes    Number of bytes to written to the serial device.
+
+  @retval 0                NumberOfBytes is 0.
+  @retval >0               The number of bytes written to the serial device.
+                           If this value is less than NumberOfBytes, then the read operation failed.
+
+**/
+UINTN
+EFIAPI
+SerialPortWrite (
+  IN UINT8  *Buffer,
+  IN UINTN  NumberOfBytes
+  )
+{
+  if (NULL == Buffer) {
+    return 0;
+  }
+
+  if (NumberOfBytes == 0) {
+    SerialPortFlushTx ();
+    return 0;
+  }
+
+  SerialPortWriteFifo (Buffer, NumberOfBytes);
+
+  return NumberOfBytes;
+}
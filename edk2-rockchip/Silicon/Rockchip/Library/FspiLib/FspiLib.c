@@ -5,6 +5,8 @@
  */
 
 #include "Soc.h"
+#include <Library/BaseMemoryLib.h>
+#include <Library/CacheMaintenanceLib.h>
 #include <Library/DebugLib.h>
 #include <Library/IoLib.h>
 #include <Library/PcdLib.h>
@@ -62,6 +64,9 @@
 #define FSPI_MAX_IOSIZE_VER3  (1024U * 8)
 #define FSPI_MAX_IOSIZE_VER4  (0xFFFFFFFFU)
 
+/* DMA buffers must not share cache lines with anything else */
+#define FSPI_DMA_ALIGN  64
+
 /********************* Private Structure Definition **************************/
 
 typedef union {
@@ -395,6 +400,120 @@ HAL_FSPI_XferData (
   return ret;
 }
 
+/**
+ * @brief  DMA transfer.
+ * @param  host: FSPI host.
+ * @param  len: data n bytes.
+ * @param  data: transfer buffer.
+ * @param  dir: transfer direction.
+ * @return RETURN_STATUS.
+ * @attention Buffers that are not cache line aligned or not 32-bit addressable
+ *            go through host->dmaBuf. If that doesn't fit either, the data is
+ *            moved by PIO instead.
+ */
+RETURN_STATUS
+HAL_FSPI_XferData_DMA (
+  struct HAL_FSPI_HOST  *host,
+  UINT32                len,
+  void                  *data,
+  UINT32                dir
+  )
+{
+  RETURN_STATUS    ret     = RETURN_SUCCESS;
+  INT32            timeout = 0;
+  struct FSPI_REG  *pReg   = host->instance;
+  void             *dmaBuf = data;
+
+  HAL_ASSERT (data && len);
+
+  if (!HAL_IS_ALIGNED ((UINTN)data, FSPI_DMA_ALIGN) ||
+      !HAL_IS_ALIGNED (len, FSPI_DMA_ALIGN) ||
+      ((UINTN)data + len - 1 > MAX_UINT32))
+  {
+    if ((host->dmaBuf == NULL) || (len > host->dmaBufSize)) {
+      return HAL_FSPI_XferData (host, len, data, dir);
+    }
+
+    dmaBuf = host->dmaBuf;
+    if (dir == FSPI_WRITE) {
+      CopyMem (dmaBuf, data, len);
+    }
+  }
+
+  if (dir == FSPI_WRITE) {
+    WriteBackDataCacheRange (dmaBuf, len);
+  } else {
+    WriteBackInvalidateDataCacheRange (dmaBuf, len);
+  }
+
+  pReg->ICLR    = FSPI_ICLR_DMAC_MASK;
+  pReg->DMAADDR = (UINT32)(UINTN)dmaBuf;
+  pReg->DMATR   = FSPI_DMATR_DMATR_START;
+
+  while (!(pReg->RISR & FSPI_RISR_DMAS_MASK)) {
+    HAL_CPUDelayUs (1);
+    if (timeout++ > 1000000) {
+      /* wait 1s */
+      ret = RETURN_TIMEOUT;
+      break;
+    }
+  }
+
+  if (ret == RETURN_TIMEOUT) {
+    /*
+     * The DMA may still be running and would write into a buffer the
+     * caller is about to free or reuse: stop it by recovering the state
+     * machine, which also flushes the FIFOs.
+     */
+    FSPI_Reset (host);
+  }
+
+  pReg->ICLR = FSPI_ICLR_DMAC_MASK;
+
+  if (dir != FSPI_WRITE) {
+    InvalidateDataCacheRange (dmaBuf, len);
+    if ((ret == RETURN_SUCCESS) && (dmaBuf != data)) {
+      CopyMem (data, dmaBuf, len);
+    }
+  }
+
+  return ret;
+}
+
+/**
+ * @brief  Mask the DMA finish interrupt.
+ * @param  host: FSPI host.
+ * @return RETURN_STATUS.
+ */
+RETURN_STATUS
+HAL_FSPI_MaskDMAInterrupt (
+  struct HAL_FSPI_HOST  *host
+  )
+{
+  HAL_ASSERT (IS_FSPI_INSTANCE (host->instance));
+
+  host->instance->IMR |= FSPI_IMR_DMAM_MASK;
+
+  return RETURN_SUCCESS;
+}
+
+/**
+ * @brief  Unmask the DMA finish interrupt.
+ * @param  host: FSPI host.
+ * @return RETURN_STATUS.
+ */
+RETURN_STATUS
+HAL_FSPI_UnmaskDMAInterrupt (
+  struct HAL_FSPI_HOST  *host
+  )
+{
+  HAL_ASSERT (IS_FSPI_INSTANCE (host->instance));
+
+  host->instance->IMR &= ~FSPI_IMR_DMAM_MASK;
+
+  return RETURN_SUCCESS;
+}
+
 /**
  * @brief  Wait for FSPI host transfer finished.
  * @return RETURN_STATUS.
@@ -449,7 +568,16 @@ HAL_FSPI_SpiXfer (
 
   HAL_FSPI_XferStart (host, op);
   if (pData) {
-    ret = HAL_FSPI_XferData (host, op->data.nbytes, pData, dir);
+    /* DMA moves whole words, only use it for large word-sized reads */
+    if (host->dmaBuf && (dir == FSPI_READ) &&
+        (op->data.nbytes >= HAL_FSPI_DMA_THRESHOLD) &&
+        HAL_IS_ALIGNED (op->data.nbytes, 4))
+    {
+      ret = HAL_FSPI_XferData_DMA (host, op->data.nbytes, pData, dir);
+    } else {
+      ret = HAL_FSPI_XferData (host, op->data.nbytes, pData, dir);
+    }
+
     if (ret) {
       FSPI_DBG ("%s xfer data failed ret %d\n", __func__, ret);
 
@@ -545,6 +673,26 @@ HAL_FSPI_SetDelayLines (
   return RETURN_SUCCESS;
 }
 
+/**
+ * @brief  Disable FSPI delay line, sampling on the SCLK edge again.
+ * @param  host: FSPI host.
+ * @return RETURN_STATUS.
+ */
+RETURN_STATUS
+HAL_FSPI_DLLDisable (
+  struct HAL_FSPI_HOST  *host
+  )
+{
+  HAL_ASSERT (IS_FSPI_INSTANCE (host->instance));
+  if (host->cs == 0) {
+    WRITE_REG (host->instance->DLL_CTRL0, 0);
+  } else {
+    WRITE_REG (host->instance->DLL_CTRL1, 0);
+  }
+
+  return RETURN_SUCCESS;
+}
+
 UINT32
 HAL_FSPI_GetMaxIoSize (
   struct HAL_FSPI_HOST  *host
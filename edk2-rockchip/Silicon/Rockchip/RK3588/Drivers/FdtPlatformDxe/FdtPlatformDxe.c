@@ -17,6 +17,7 @@
 #include <Library/PrintLib.h>
 #include <Library/DxeServicesLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/PerformanceLib.h>
 #include <Library/RockchipPlatformLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiLib.h>
@@ -1039,7 +1040,9 @@ FdtPlatformProcessLoadedImage (
       FreePool (DevicePathText);
     }
 
+    PERF_INMODULE_BEGIN ("FdtProcessFileSystem");
     Status = FdtPlatformProcessFileSystem (FileSystem);
+    PERF_INMODULE_END ("FdtProcessFileSystem");
     if (EFI_ERROR (Status)) {
       if (Status != EFI_NOT_FOUND) {
         DEBUG ((DEBUG_ERROR, "FdtPlatform: Failed to process the file system. Status=%r\n", Status));
@@ -17,7 +17,27 @@ EFI_STATUS
   IN UINT32                 PhyId
   );
 
-VOID
+//
+// PHY init sequences are described as register scripts and run back to
+// back, each MDIO access completing as soon as the GMII busy bit clears.
+//
+typedef enum {
+  PhyScriptWrite,   // Reg = Value
+  PhyScriptModify   // Reg = (Reg & ~Mask) | Value
+} PHY_SCRIPT_OP;
+
+typedef struct {
+  PHY_SCRIPT_OP    Op;
+  UINT16           Reg;
+  UINT16           Mask;
+  UINT16           Value;
+} PHY_SCRIPT_ENTRY;
+
+#define PHY_SCRIPT_WRITE(_Reg, _Value)  { PhyScriptWrite, (_Reg), 0, (_Value) }
+#define PHY_SCRIPT_MODIFY(_Reg, _Mask, _Value) \
+  { PhyScriptModify, (_Reg), (_Mask), (_Value) }
+
+EFI_STATUS
 PhyRead (
   IN  EFI_PHYSICAL_ADDRESS  GmacBase,
   IN  UINT8                 Phy,
@@ -25,7 +45,7 @@ PhyRead (
   OUT UINT16                *Value
   );
 
-VOID
+EFI_STATUS
 PhyWrite (
   IN EFI_PHYSICAL_ADDRESS  GmacBase,
   IN UINT8                 Phy,
@@ -33,6 +53,14 @@ PhyWrite (
   IN UINT16                Value
   );
 
+EFI_STATUS
+PhyRunScript (
+  IN EFI_PHYSICAL_ADDRESS    GmacBase,
+  IN UINT8                   Phy,
+  IN CONST PHY_SCRIPT_ENTRY  *Script,
+  IN UINTN                   Count
+  );
+
 EFI_STATUS
 EFIAPI
 RealtekPhyInit (
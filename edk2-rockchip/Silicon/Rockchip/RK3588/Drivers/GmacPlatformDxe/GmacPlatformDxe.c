@@ -71,18 +71,6 @@
 #define RK3588_GMAC_CLK_RX_DL_CFG(val)  HIWORD_UPDATE(val, 0xFF, 8)
 #define RK3588_GMAC_CLK_TX_DL_CFG(val)  HIWORD_UPDATE(val, 0xFF, 0)
 
-/* GMAC registers */
-#define  GMAC_MAC_MDIO_ADDRESS              0x0200
-#define   GMAC_MAC_MDIO_ADDRESS_PA_SHIFT    21
-#define   GMAC_MAC_MDIO_ADDRESS_RDA_SHIFT   16
-#define   GMAC_MAC_MDIO_ADDRESS_CR_SHIFT    8
-#define   GMAC_MAC_MDIO_ADDRESS_CR_100_150  (1U << GMAC_MAC_MDIO_ADDRESS_CR_SHIFT)
-#define   GMAC_MAC_MDIO_ADDRESS_GOC_SHIFT   2
-#define   GMAC_MAC_MDIO_ADDRESS_GOC_READ    (3U << GMAC_MAC_MDIO_ADDRESS_GOC_SHIFT)
-#define   GMAC_MAC_MDIO_ADDRESS_GOC_WRITE   (1U << GMAC_MAC_MDIO_ADDRESS_GOC_SHIFT)
-#define   GMAC_MAC_MDIO_ADDRESS_GB          BIT0
-#define  GMAC_MAC_MDIO_DATA                 0x0204
-
 /* MII registers */
 #define MII_PHYIDR1  0x02
 #define MII_PHYIDR2  0x03
@@ -186,80 +174,6 @@ STATIC ETHERNET_PHY_INIT  mPhyInitList[] = {
   MotorcommPhyInit
 };
 
-VOID
-PhyRead (
-  IN  EFI_PHYSICAL_ADDRESS  GmacBase,
-  IN  UINT8                 Phy,
-  IN  UINT16                Reg,
-  OUT UINT16                *Value
-  )
-{
-  UINT32  Addr;
-  UINTN   Retry;
-
-  Addr = GMAC_MAC_MDIO_ADDRESS_CR_100_150 |
-         (Phy << GMAC_MAC_MDIO_ADDRESS_PA_SHIFT) |
-         (Reg << GMAC_MAC_MDIO_ADDRESS_RDA_SHIFT) |
-         GMAC_MAC_MDIO_ADDRESS_GOC_READ |
-         GMAC_MAC_MDIO_ADDRESS_GB;
-  MmioWrite32 (GmacBase + GMAC_MAC_MDIO_ADDRESS, Addr);
-
-  MicroSecondDelay (10000);
-
-  for (Retry = 1000; Retry > 0; Retry--) {
-    Addr = MmioRead32 (GmacBase + GMAC_MAC_MDIO_ADDRESS);
-    if ((Addr & GMAC_MAC_MDIO_ADDRESS_GB) == 0) {
-      *Value = MmioRead32 (GmacBase + GMAC_MAC_MDIO_DATA) & 0xFFFFu;
-      break;
-    }
-
-    MicroSecondDelay (10);
-  }
-
-  if (Retry == 0) {
-    DEBUG ((DEBUG_WARN, "MDIO: PHY read timeout!\n"));
-    *Value = 0xFFFFU;
-    ASSERT (FALSE);
-  }
-}
-
-VOID
-PhyWrite (
-  IN EFI_PHYSICAL_ADDRESS  GmacBase,
-  IN UINT8                 Phy,
-  IN UINT16                Reg,
-  IN UINT16                Value
-  )
-{
-  UINT32  Addr;
-  UINTN   Retry;
-
-  MmioWrite32 (GmacBase + GMAC_MAC_MDIO_DATA, Value);
-
-  Addr = GMAC_MAC_MDIO_ADDRESS_CR_100_150 |
-         (Phy << GMAC_MAC_MDIO_ADDRESS_PA_SHIFT) |
-         (Reg << GMAC_MAC_MDIO_ADDRESS_RDA_SHIFT) |
-         GMAC_MAC_MDIO_ADDRESS_GOC_WRITE |
-         GMAC_MAC_MDIO_ADDRESS_GB;
-  MmioWrite32 (GmacBase + GMAC_MAC_MDIO_ADDRESS, Addr);
-
-  MicroSecondDelay (10000);
-
-  for (Retry = 1000; Retry > 0; Retry--) {
-    Addr = MmioRead32 (GmacBase + GMAC_MAC_MDIO_ADDRESS);
-    if ((Addr & GMAC_MAC_MDIO_ADDRESS_GB) == 0) {
-      break;
-    }
-
-    MicroSecondDelay (10);
-  }
-
-  if (Retry == 0) {
-    DEBUG ((DEBUG_WARN, "MDIO: PHY write timeout!\n"));
-    ASSERT (FALSE);
-  }
-}
-
 STATIC
 VOID
 EFIAPI
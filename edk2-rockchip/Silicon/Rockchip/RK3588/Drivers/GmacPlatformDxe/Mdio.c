@@ -0,0 +1,164 @@
+/** @file
+ *
+ *  RK3588 GMAC MDIO accessors
+ *
+ *  Copyright (c) 2021-2022, Jared McNeill <jmcneill@invisible.ca>
+ *  Copyright (c) 2023-2025, Mario Bălănică <mariobalanica02@gmail.com>
+ *
+ *  SPDX-License-Identifier: BSD-2-Clause-Patent
+ *
+ **/
+
+#include <Library/DebugLib.h>
+#include <Library/IoLib.h>
+#include <Library/TimerLib.h>
+
+#include "EthernetPhy.h"
+
+/* GMAC registers */
+#define  GMAC_MAC_MDIO_ADDRESS              0x0200
+#define   GMAC_MAC_MDIO_ADDRESS_PA_SHIFT    21
+#define   GMAC_MAC_MDIO_ADDRESS_RDA_SHIFT   16
+#define   GMAC_MAC_MDIO_ADDRESS_CR_SHIFT    8
+#define   GMAC_MAC_MDIO_ADDRESS_CR_100_150  (1U << GMAC_MAC_MDIO_ADDRESS_CR_SHIFT)
+#define   GMAC_MAC_MDIO_ADDRESS_GOC_SHIFT   2
+#define   GMAC_MAC_MDIO_ADDRESS_GOC_READ    (3U << GMAC_MAC_MDIO_ADDRESS_GOC_SHIFT)
+#define   GMAC_MAC_MDIO_ADDRESS_GOC_WRITE   (1U << GMAC_MAC_MDIO_ADDRESS_GOC_SHIFT)
+#define   GMAC_MAC_MDIO_ADDRESS_GB          BIT0
+#define  GMAC_MAC_MDIO_DATA                 0x0204
+
+//
+// A single MDIO frame takes ~26 us at the 2.5 MHz MDC we get from the
+// 125 MHz CSR clock (CR_100_150 divides by 62), so poll the busy bit
+// finely and only give up well past any sane completion time.
+//
+#define MDIO_POLL_INTERVAL_US  1
+#define MDIO_TIMEOUT_US        10000
+
+/**
+  Start an MDIO transaction and wait for the GMII busy bit to clear.
+
+  @param[in]  GmacBase    GMAC register base.
+  @param[in]  Phy         PHY address.
+  @param[in]  Reg         PHY register.
+  @param[in]  Operation   GMAC_MAC_MDIO_ADDRESS_GOC_* value.
+
+  @retval EFI_SUCCESS   The transaction completed.
+  @retval EFI_TIMEOUT   The busy bit did not clear in time.
+**/
+STATIC
+EFI_STATUS
+MdioTransfer (
+  IN EFI_PHYSICAL_ADDRESS  GmacBase,
+  IN UINT8                 Phy,
+  IN UINT16                Reg,
+  IN UINT32                Operation
+  )
+{
+  UINT32  Addr;
+  UINTN   Elapsed;
+
+  Addr = GMAC_MAC_MDIO_ADDRESS_CR_100_150 |
+         (Phy << GMAC_MAC_MDIO_ADDRESS_PA_SHIFT) |
+         (Reg << GMAC_MAC_MDIO_ADDRESS_RDA_SHIFT) |
+         Operation |
+         GMAC_MAC_MDIO_ADDRESS_GB;
+  MmioWrite32 (GmacBase + GMAC_MAC_MDIO_ADDRESS, Addr);
+
+  for (Elapsed = 0; Elapsed < MDIO_TIMEOUT_US; Elapsed += MDIO_POLL_INTERVAL_US) {
+    MicroSecondDelay (MDIO_POLL_INTERVAL_US);
+
+    Addr = MmioRead32 (GmacBase + GMAC_MAC_MDIO_ADDRESS);
+    if ((Addr & GMAC_MAC_MDIO_ADDRESS_GB) == 0) {
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_TIMEOUT;
+}
+
+EFI_STATUS
+PhyRead (
+  IN  EFI_PHYSICAL_ADDRESS  GmacBase,
+  IN  UINT8                 Phy,
+  IN  UINT16                Reg,
+  OUT UINT16                *Value
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = MdioTransfer (GmacBase, Phy, Reg, GMAC_MAC_MDIO_ADDRESS_GOC_READ);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "MDIO: PHY read timeout!\n"));
+    *Value = 0xFFFFU;
+    ASSERT (FALSE);
+    return Status;
+  }
+
+  *Value = MmioRead32 (GmacBase + GMAC_MAC_MDIO_DATA) & 0xFFFFu;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+PhyWrite (
+  IN EFI_PHYSICAL_ADDRESS  GmacBase,
+  IN UINT8                 Phy,
+  IN UINT16                Reg,
+  IN UINT16                Value
+  )
+{
+  EFI_STATUS  Status;
+
+  MmioWrite32 (GmacBase + GMAC_MAC_MDIO_DATA, Value);
+
+  Status = MdioTransfer (GmacBase, Phy, Reg, GMAC_MAC_MDIO_ADDRESS_GOC_WRITE);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "MDIO: PHY write timeout!\n"));
+    ASSERT (FALSE);
+  }
+
+  return Status;
+}
+
+EFI_STATUS
+PhyRunScript (
+  IN EFI_PHYSICAL_ADDRESS    GmacBase,
+  IN UINT8                   Phy,
+  IN CONST PHY_SCRIPT_ENTRY  *Script,
+  IN UINTN                   Count
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Index;
+  UINT16      Data;
+
+  for (Index = 0; Index < Count; Index++) {
+    switch (Script[Index].Op) {
+      case PhyScriptWrite:
+        Status = PhyWrite (GmacBase, Phy, Script[Index].Reg, Script[Index].Value);
+        break;
+
+      case PhyScriptModify:
+        Status = PhyRead (GmacBase, Phy, Script[Index].Reg, &Data);
+        if (EFI_ERROR (Status)) {
+          break;
+        }
+
+        Data   = (Data & ~Script[Index].Mask) | Script[Index].Value;
+        Status = PhyWrite (GmacBase, Phy, Script[Index].Reg, Data);
+        break;
+
+      default:
+        ASSERT (FALSE);
+        Status = EFI_INVALID_PARAMETER;
+        break;
+    }
+
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a: Step %u failed: %r\n", __func__, Index, Status));
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
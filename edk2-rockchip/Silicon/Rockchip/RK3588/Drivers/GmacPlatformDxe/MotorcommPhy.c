@@ -9,7 +9,6 @@
 
 #include <Base.h>
 #include <Library/DebugLib.h>
-#include <Library/TimerLib.h>
 
 #include "EthernetPhy.h"
 
@@ -38,49 +37,50 @@
 #define LED2_CFG_REG       0xA00E
 #define LED_BLINK_CFG_REG  0xA00F
 
-STATIC
-VOID
-YT8531PhyInit (
-  IN EFI_PHYSICAL_ADDRESS  GmacBase
-  )
-{
-  UINT16  OldAddr;
-  UINT16  Data;
-
-  PhyRead (GmacBase, 0, EXT_REG_ADDR, &OldAddr);
-
-  PhyWrite (GmacBase, 0, EXT_REG_ADDR, YTPHY_SYNCE_CFG_REG);
-  PhyWrite (
-    GmacBase,
-    0,
+STATIC CONST PHY_SCRIPT_ENTRY  mYT8531InitScript[] = {
+  PHY_SCRIPT_WRITE (EXT_REG_ADDR, YTPHY_SYNCE_CFG_REG),
+  PHY_SCRIPT_WRITE (
     EXT_REG_DATA,
     YT8531_SCR_SYNCE_ENABLE |
     YT8531_SCR_CLK_FRE_SEL_125M |
     YT8531_SCR_CLK_SRC_SEL_PLL_125M
-    );
+    ),
 
-  PhyWrite (GmacBase, 0, EXT_REG_ADDR, PHY_CLOCK_GATING_REG);
-  PhyRead (GmacBase, 0, EXT_REG_DATA, &Data);
-  Data &= ~RX_CLK_EN;
-  Data &= ~CLK_25M_SEL_MASK;
-  Data |= CLK_25M_SEL_125M;
-  PhyWrite (GmacBase, 0, EXT_REG_DATA, Data);
+  PHY_SCRIPT_WRITE (EXT_REG_ADDR, PHY_CLOCK_GATING_REG),
+  PHY_SCRIPT_MODIFY (EXT_REG_DATA, RX_CLK_EN | CLK_25M_SEL_MASK, CLK_25M_SEL_125M),
 
-  PhyWrite (GmacBase, 0, EXT_REG_ADDR, PHY_SLEEP_CONTROL1_REG);
-  PhyRead (GmacBase, 0, EXT_REG_DATA, &Data);
-  Data &= ~SLEEP_SW;
-  PhyWrite (GmacBase, 0, EXT_REG_DATA, Data);
+  PHY_SCRIPT_WRITE (EXT_REG_ADDR, PHY_SLEEP_CONTROL1_REG),
+  PHY_SCRIPT_MODIFY (EXT_REG_DATA, SLEEP_SW, 0),
 
-  PhyWrite (GmacBase, 0, EXT_REG_ADDR, LED1_CFG_REG);
-  PhyWrite (GmacBase, 0, EXT_REG_DATA, 0x0670);
+  PHY_SCRIPT_WRITE (EXT_REG_ADDR, LED1_CFG_REG),
+  PHY_SCRIPT_WRITE (EXT_REG_DATA, 0x0670),
 
-  PhyWrite (GmacBase, 0, EXT_REG_ADDR, LED2_CFG_REG);
-  PhyWrite (GmacBase, 0, EXT_REG_DATA, 0x2070);
+  PHY_SCRIPT_WRITE (EXT_REG_ADDR, LED2_CFG_REG),
+  PHY_SCRIPT_WRITE (EXT_REG_DATA, 0x2070),
 
-  PhyWrite (GmacBase, 0, EXT_REG_ADDR, LED_BLINK_CFG_REG);
-  PhyWrite (GmacBase, 0, EXT_REG_DATA, 0x007e);
+  PHY_SCRIPT_WRITE (EXT_REG_ADDR, LED_BLINK_CFG_REG),
+  PHY_SCRIPT_WRITE (EXT_REG_DATA, 0x007e),
+};
+
+STATIC
+EFI_STATUS
+YT8531PhyInit (
+  IN EFI_PHYSICAL_ADDRESS  GmacBase
+  )
+{
+  EFI_STATUS  Status;
+  UINT16      OldAddr;
+
+  Status = PhyRead (GmacBase, 0, EXT_REG_ADDR, &OldAddr);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = PhyRunScript (GmacBase, 0, mYT8531InitScript, ARRAY_SIZE (mYT8531InitScript));
 
   PhyWrite (GmacBase, 0, EXT_REG_ADDR, OldAddr);
+
+  return Status;
 }
 
 EFI_STATUS
@@ -93,11 +93,8 @@ MotorcommPhyInit (
   switch (PhyId) {
     case 0x4F51E91B:
       DEBUG ((DEBUG_INFO, "%a: Found Motorcomm YT8531 GbE PHY\n", __func__));
-      YT8531PhyInit (GmacBase);
-      break;
+      return YT8531PhyInit (GmacBase);
     default:
       return EFI_UNSUPPORTED;
   }
-
-  return EFI_SUCCESS;
 }
@@ -9,7 +9,6 @@
 
 #include <Base.h>
 #include <Library/DebugLib.h>
-#include <Library/TimerLib.h>
 
 #include "EthernetPhy.h"
 
@@ -18,17 +17,19 @@
 #define LCR        0x10
 #define LCR_VALUE  0x6940
 
+STATIC CONST PHY_SCRIPT_ENTRY  mRTL8211FInitScript[] = {
+  PHY_SCRIPT_WRITE (PAGSR, 0xD04),
+  PHY_SCRIPT_WRITE (LCR,   LCR_VALUE),
+  PHY_SCRIPT_WRITE (PAGSR, 0),
+};
+
 STATIC
-VOID
+EFI_STATUS
 RTL8211FPhyInit (
   IN EFI_PHYSICAL_ADDRESS  GmacBase
   )
 {
-  PhyWrite (GmacBase, 0, PAGSR, 0xD04);
-  MicroSecondDelay (10000);
-  PhyWrite (GmacBase, 0, LCR, LCR_VALUE);
-  MicroSecondDelay (10000);
-  PhyWrite (GmacBase, 0, PAGSR, 0);
+  return PhyRunScript (GmacBase, 0, mRTL8211FInitScript, ARRAY_SIZE (mRTL8211FInitScript));
 }
 
 EFI_STATUS
@@ -41,15 +42,11 @@ RealtekPhyInit (
   switch (PhyId) {
     case 0x001CC916:
       DEBUG ((DEBUG_INFO, "%a: Found Realtek RTL8211F GbE PHY\n", __func__));
-      RTL8211FPhyInit (GmacBase);
-      break;
+      return RTL8211FPhyInit (GmacBase);
     case 0x001CC878:
       DEBUG ((DEBUG_INFO, "%a: Found Realtek RTL8211F-VD GbE PHY\n", __func__));
-      RTL8211FPhyInit (GmacBase);
-      break;
+      return RTL8211FPhyInit (GmacBase);
     default:
       return EFI_UNSUPPORTED;
   }
-
-  return EFI_SUCCESS;
 }
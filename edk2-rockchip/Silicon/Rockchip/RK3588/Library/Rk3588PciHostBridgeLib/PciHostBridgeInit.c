@@ -11,6 +11,7 @@
 
 #include <PiDxe.h>
 #include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
 #include <Library/PrintLib.h>
 #include <Library/DebugLib.h>
 #include <Library/IoLib.h>
@@ -20,7 +21,9 @@
 #include <Library/Rk3588Pcie.h>
 #include <Library/RockchipPlatformLib.h>
 #include <Library/Pcie30PhyLib.h>
+#include <Library/PerformanceLib.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
 #include <IndustryStandard/Pci.h>
 #include <VarStoreData.h>
 
@@ -45,6 +48,7 @@
 #define  RDLH_LINK_UP                   BIT17
 #define  SMLH_LINK_UP                   BIT16
 #define  SMLH_LTSSM_STATE_MASK          0x3f
+#define  SMLH_LTSSM_STATE_DETECT_ACT    0x01
 #define  SMLH_LTSSM_STATE_LINK_UP       0x11
 
 /* DBI Registers */
@@ -91,6 +95,16 @@
 #define IATU_LWR_TARGET_ADDR_OFF    0x014
 #define IATU_UPPER_TARGET_ADDR_OFF  0x018
 
+#define PCIE_CFG0_BASE  SIZE_1MB
+
+/* Link bring-up timing */
+#define PCIE_POWER_UP_DELAY_US          100000
+#define PCIE_PERST_DELAY_US             100000
+#define PCIE_LINK_UP_TIMEOUT_US         1000000
+#define PCIE_LINK_DETECT_TIMEOUT_US     100000
+#define PCIE_LINK_POLL_MIN_INTERVAL_US  1000
+#define PCIE_LINK_POLL_MAX_INTERVAL_US  16000
+
 BOOLEAN
 IsPcieNumEnabled (
   UINTN  PcieNum
@@ -419,16 +433,24 @@ PciEnableLtssm (
 STATIC
 BOOLEAN
 PciIsLinkUp (
-  IN EFI_PHYSICAL_ADDRESS  ApbBase
+  IN UINT32                Segment,
+  IN EFI_PHYSICAL_ADDRESS  ApbBase,
+  OUT UINT32               *LtssmStatus OPTIONAL
   )
 {
-  STATIC UINT32  LastVal = 0xFFFFFFFF;
+  STATIC UINT32  LastVal[NUM_PCIE_CONTROLLER] = {
+    0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF
+  };
   UINT32         Val;
 
   Val = MmioRead32 (ApbBase + PCIE_CLIENT_LTSSM_STATUS);
-  if (Val != LastVal) {
-    DEBUG ((DEBUG_INIT, "PCIe: PciIsLinkUp(): LTSSM_STATUS=0x%08X\n", Val));
-    LastVal = Val;
+  if (Val != LastVal[Segment]) {
+    DEBUG ((DEBUG_INIT, "PCIe: PciIsLinkUp(%u): LTSSM_STATUS=0x%08X\n", Segment, Val));
+    LastVal[Segment] = Val;
+  }
+
+  if (LtssmStatus != NULL) {
+    *LtssmStatus = Val;
   }
 
   if ((Val & RDLH_LINK_UP) == 0) {
@@ -569,25 +591,15 @@ STATIC struct {
   },
 };
 
+STATIC
 EFI_STATUS
-InitializePciHost (
-  UINT32  Segment
+PciGetTargetLinkSpeedWidth (
+  IN  UINT32  Segment,
+  OUT UINT32  *LinkSpeed,
+  OUT UINT32  *LinkWidth
   )
 {
-  EFI_PHYSICAL_ADDRESS  ApbBase  = PCIE_APB_BASE (Segment);
-  EFI_PHYSICAL_ADDRESS  DbiBase  = PCIE_DBI_BASE (Segment);
-  EFI_PHYSICAL_ADDRESS  PcieBase = PCIE_CFG_BASE (Segment);
-  EFI_STATUS            Status;
-  UINTN                 Retry;
-  UINT32                LinkSpeed;
-  UINT32                LinkWidth;
-  UINT64                Cfg0Base;
-  UINT64                Cfg0Size;
-  UINT64                Cfg1Base;
-  UINT64                Cfg1Size;
-  UINT64                PciIoBase;
-  UINT64                PciIoSize;
-  UINT8                 Pcie30PhyMode;
+  UINT8  Pcie30PhyMode;
 
   Pcie30PhyMode = PcdGet8 (PcdPcie30PhyMode);
   if (Pcie30PhyMode >= NUM_MODES) {
@@ -601,25 +613,89 @@ InitializePciHost (
     return EFI_INVALID_PARAMETER;
   }
 
-  LinkSpeed = LinkSpeedWidthMap[Pcie30PhyMode][Segment].Speed;
-  LinkWidth = LinkSpeedWidthMap[Pcie30PhyMode][Segment].Width;
-  if ((LinkSpeed == 0) || (LinkWidth == 0)) {
+  *LinkSpeed = LinkSpeedWidthMap[Pcie30PhyMode][Segment].Speed;
+  *LinkWidth = LinkSpeedWidthMap[Pcie30PhyMode][Segment].Width;
+  if ((*LinkSpeed == 0) || (*LinkWidth == 0)) {
     /* should never here */
     DEBUG ((DEBUG_WARN, "PCIe: Segment %u not enabled\n", Segment));
     return EFI_UNSUPPORTED;
   }
 
+  return EFI_SUCCESS;
+}
+
+/**
+  First phase of the controller bring-up: route the pins and switch on
+  slot power. The caller waits for power to settle once for all segments.
+
+  @param[in]  Segment   The PCIe segment.
+
+  @retval EFI_SUCCESS   Slot power has been enabled.
+  @retval Others        The segment cannot be used.
+**/
+STATIC
+EFI_STATUS
+PciHostPowerUp (
+  IN UINT32  Segment
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      LinkSpeed;
+  UINT32      LinkWidth;
+
+  Status = PciGetTargetLinkSpeedWidth (Segment, &LinkSpeed, &LinkWidth);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
   /* Log settings */
   DEBUG ((DEBUG_INIT, "\nPCIe: Segment %u\n", Segment));
-  DEBUG ((DEBUG_INIT, "PCIe: PciExpressBaseAddress 0x%lx\n", PcieBase));
-  DEBUG ((DEBUG_INIT, "PCIe: ApbBase 0x%lx\n", ApbBase));
-  DEBUG ((DEBUG_INIT, "PCIe: DbiBase 0x%lx\n", DbiBase));
+  DEBUG ((DEBUG_INIT, "PCIe: PciExpressBaseAddress 0x%lx\n", PCIE_CFG_BASE (Segment)));
+  DEBUG ((DEBUG_INIT, "PCIe: ApbBase 0x%lx\n", PCIE_APB_BASE (Segment)));
+  DEBUG ((DEBUG_INIT, "PCIe: DbiBase 0x%lx\n", PCIE_DBI_BASE (Segment)));
   DEBUG ((DEBUG_INIT, "PCIe: NumLanes %u\n", LinkWidth));
   DEBUG ((DEBUG_INIT, "PCIe: LinkSpeed %u\n", LinkSpeed));
 
   PcieIoInit (Segment);
   PciePowerEn (Segment, TRUE);
-  gBS->Stall (100000);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Second phase of the controller bring-up: configure the PHY, clocks,
+  root port and iATU, then start the LTSSM with PERST# still asserted.
+
+  @param[in]  Segment   The PCIe segment.
+
+  @retval EFI_SUCCESS   Link training has been started.
+  @retval Others        The segment cannot be used.
+**/
+STATIC
+EFI_STATUS
+PciHostStartLink (
+  IN UINT32  Segment
+  )
+{
+  EFI_PHYSICAL_ADDRESS  ApbBase  = PCIE_APB_BASE (Segment);
+  EFI_PHYSICAL_ADDRESS  DbiBase  = PCIE_DBI_BASE (Segment);
+  EFI_PHYSICAL_ADDRESS  PcieBase = PCIE_CFG_BASE (Segment);
+  EFI_STATUS            Status;
+  UINT32                LinkSpeed;
+  UINT32                LinkWidth;
+  UINT64                Cfg0Base;
+  UINT64                Cfg0Size;
+  UINT64                Cfg1Base;
+  UINT64                Cfg1Size;
+  UINT64                PciIoBase;
+  UINT64                PciIoSize;
+
+  Status = PciGetTargetLinkSpeedWidth (Segment, &LinkSpeed, &LinkWidth);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  DEBUG ((DEBUG_INIT, "\nPCIe: Segment %u\n", Segment));
 
   if ((Segment == PCIE_SEGMENT_PCIE30X4) || (Segment == PCIE_SEGMENT_PCIE30X2)) {
     /* Configure PCIe 3.0 PHY */
@@ -645,7 +721,7 @@ InitializePciHost (
   PciSetupBars (DbiBase);
 
   DEBUG ((DEBUG_INIT, "PCIe: Setup iATU\n"));
-  Cfg0Base  = SIZE_1MB;
+  Cfg0Base  = PCIE_CFG0_BASE;
   Cfg0Size  = SIZE_64KB;
   Cfg1Base  = SIZE_2MB;
   Cfg1Size  = 0x10000000UL - (SIZE_2MB + SIZE_64KB);
@@ -667,32 +743,292 @@ InitializePciHost (
   PciePeReset (Segment, TRUE);
 
   DEBUG ((DEBUG_INIT, "PCIe: Start LTSSM\n"));
-
   PciEnableLtssm (ApbBase, TRUE);
 
-  gBS->Stall (100000);
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+PciHostLinkUp (
+  IN UINT32  Segment
+  )
+{
+  UINT32  LinkSpeed;
+  UINT32  LinkWidth;
+
+  DEBUG ((DEBUG_INIT, "\nPCIe: Segment %u\n", Segment));
+  PciGetLinkSpeedWidth (PCIE_DBI_BASE (Segment), &LinkSpeed, &LinkWidth);
+  PciPrintLinkSpeedWidth (LinkSpeed, LinkWidth);
+
+  PciValidateCfg0 (Segment, PCIE_CFG_BASE (Segment) + PCIE_CFG0_BASE);
+}
+
+//
+// Link training history, kept across boots so that slots which had
+// nothing in them last time don't hold up boot for the full link-up
+// timeout. A slot whose LTSSM gets past Detect is always given the full
+// timeout, which covers devices added since the history was recorded.
+//
+#define PCIE_LINK_HISTORY_VARIABLE_NAME  L"PcieLinkTrainingHistory"
+
+typedef struct {
+  UINT32    ProbedMask;
+  UINT32    LinkUpMask;
+  UINT32    TrainTimeUs[NUM_PCIE_CONTROLLER];
+} PCIE_LINK_HISTORY;
+
+STATIC
+VOID
+PciLoadLinkHistory (
+  OUT PCIE_LINK_HISTORY  *History
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Size;
+
+  Size   = sizeof (*History);
+  Status = gRT->GetVariable (
+                  PCIE_LINK_HISTORY_VARIABLE_NAME,
+                  &gRK3588PcieLinkHistoryGuid,
+                  NULL,
+                  &Size,
+                  History
+                  );
+  if (EFI_ERROR (Status) || (Size != sizeof (*History))) {
+    ZeroMem (History, sizeof (*History));
+  }
+}
+
+STATIC
+VOID
+PciSaveLinkHistory (
+  IN PCIE_LINK_HISTORY  *History,
+  IN UINT32             ProbedMask,
+  IN UINT32             LinkUpMask,
+  IN UINT32             *TrainTimeUs
+  )
+{
+  EFI_STATUS  Status;
+  BOOLEAN     Changed;
+  UINT32      Segment;
+
+  Changed = (History->ProbedMask != ProbedMask) || (History->LinkUpMask != LinkUpMask);
+
+  for (Segment = 0; Segment < NUM_PCIE_CONTROLLER; Segment++) {
+    if ((LinkUpMask & (1U << Segment)) == 0) {
+      TrainTimeUs[Segment] = 0;
+    }
+
+    //
+    // Training time jitters from boot to boot; only rewrite the variable
+    // when it moves by more than a factor of two to spare the flash.
+    //
+    if (  (TrainTimeUs[Segment] > History->TrainTimeUs[Segment] * 2)
+       || (TrainTimeUs[Segment] < History->TrainTimeUs[Segment] / 2))
+    {
+      Changed = TRUE;
+    }
+  }
+
+  if (!Changed) {
+    return;
+  }
+
+  History->ProbedMask = ProbedMask;
+  History->LinkUpMask = LinkUpMask;
+  CopyMem (History->TrainTimeUs, TrainTimeUs, sizeof (History->TrainTimeUs));
+
+  Status = gRT->SetVariable (
+                  PCIE_LINK_HISTORY_VARIABLE_NAME,
+                  &gRK3588PcieLinkHistoryGuid,
+                  EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                  sizeof (*History),
+                  History
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "PCIe: Failed to save link training history: %r\n", Status));
+  }
+}
+
+/**
+  Get how long to wait for a receiver to be detected on a segment before
+  giving up on it.
+
+  @param[in]  History   Link training history from the previous boot.
+  @param[in]  Segment   The PCIe segment.
+
+  @return The timeout in microseconds, counted from PERST# deassertion.
+**/
+STATIC
+UINTN
+PciGetLinkDetectTimeout (
+  IN PCIE_LINK_HISTORY  *History,
+  IN UINT32             Segment
+  )
+{
+  UINTN  Timeout;
+
+  if ((History->ProbedMask & (1U << Segment)) == 0) {
+    return PCIE_LINK_UP_TIMEOUT_US;
+  }
+
+  if ((History->LinkUpMask & (1U << Segment)) == 0) {
+    return PCIE_LINK_DETECT_TIMEOUT_US;
+  }
+
+  Timeout = (UINTN)History->TrainTimeUs[Segment] * 2 + PCIE_LINK_DETECT_TIMEOUT_US;
+  return MIN (Timeout, PCIE_LINK_UP_TIMEOUT_US);
+}
+
+//
+// Per-segment bring-up measurements, from power-up to link up or give-up.
+//
+STATIC CONST CHAR8  *mPciHostPerfNames[NUM_SEGMENTS] = {
+  "PciHost0", "PciHost1", "PciHost2", "PciHost3", "PciHost4"
+};
+
+/**
+  Bring up a set of PCIe controllers.
+
+  The fixed power-on and PERST# delays are paid once for all segments, and
+  link training on every segment then runs concurrently, with a single loop
+  polling each LTSSM until it reports link up or the shared timeout expires.
+
+  Polling starts at 1 ms and backs off exponentially. Segments whose LTSSM
+  never leaves Detect are dropped early, after a timeout derived from the
+  training time recorded on the previous boot.
+
+  @param[in,out]  SegmentMask   On input, the segments to initialize.
+                                On output, the segments whose link came up.
+
+  @retval EFI_SUCCESS     At least one link came up.
+  @retval EFI_NOT_FOUND   No link came up.
+**/
+EFI_STATUS
+InitializePciHosts (
+  IN OUT UINT32  *SegmentMask
+  )
+{
+  EFI_STATUS         Status;
+  UINT32             Pending;
+  UINT32             LinkUp;
+  UINT32             Detected;
+  UINT32             Segment;
+  UINT32             LtssmStatus;
+  UINT32             TrainTimeUs[NUM_PCIE_CONTROLLER];
+  UINTN              Elapsed;
+  UINTN              Interval;
+  PCIE_LINK_HISTORY  History;
+
+  Pending = 0;
+  for (Segment = 0; Segment < NUM_SEGMENTS; Segment++) {
+    if ((*SegmentMask & (1U << Segment)) == 0) {
+      continue;
+    }
+
+    PERF_INMODULE_BEGIN (mPciHostPerfNames[Segment]);
+
+    Status = PciHostPowerUp (Segment);
+    if (!EFI_ERROR (Status)) {
+      Pending |= 1U << Segment;
+    } else {
+      PERF_INMODULE_END (mPciHostPerfNames[Segment]);
+    }
+  }
+
+  if (Pending == 0) {
+    *SegmentMask = 0;
+    return EFI_NOT_FOUND;
+  }
+
+  gBS->Stall (PCIE_POWER_UP_DELAY_US);
+
+  for (Segment = 0; Segment < NUM_SEGMENTS; Segment++) {
+    if ((Pending & (1U << Segment)) == 0) {
+      continue;
+    }
+
+    Status = PciHostStartLink (Segment);
+    if (EFI_ERROR (Status)) {
+      Pending &= ~(1U << Segment);
+      PERF_INMODULE_END (mPciHostPerfNames[Segment]);
+    }
+  }
+
+  if (Pending == 0) {
+    *SegmentMask = 0;
+    return EFI_NOT_FOUND;
+  }
+
+  gBS->Stall (PCIE_PERST_DELAY_US);
+
   DEBUG ((DEBUG_INIT, "PCIe: Deassert reset\n"));
-  PciePeReset (Segment, FALSE);
+  for (Segment = 0; Segment < NUM_SEGMENTS; Segment++) {
+    if ((Pending & (1U << Segment)) != 0) {
+      PciePeReset (Segment, FALSE);
+    }
+  }
 
   /* Wait for link up */
   DEBUG ((DEBUG_INIT, "PCIe: Waiting for link up...\n"));
-  for (Retry = 10; Retry != 0; Retry--) {
-    if (PciIsLinkUp (ApbBase)) {
+  PciLoadLinkHistory (&History);
+  ZeroMem (TrainTimeUs, sizeof (TrainTimeUs));
+
+  LinkUp   = 0;
+  Detected = 0;
+  Interval = PCIE_LINK_POLL_MIN_INTERVAL_US;
+  for (Elapsed = 0; ; ) {
+    for (Segment = 0; Segment < NUM_SEGMENTS; Segment++) {
+      if ((Pending & (1U << Segment)) == 0) {
+        continue;
+      }
+
+      if (PciIsLinkUp (Segment, PCIE_APB_BASE (Segment), &LtssmStatus)) {
+        Pending             &= ~(1U << Segment);
+        LinkUp              |= 1U << Segment;
+        TrainTimeUs[Segment] = (UINT32)Elapsed;
+        PciHostLinkUp (Segment);
+        PERF_INMODULE_END (mPciHostPerfNames[Segment]);
+        DEBUG ((DEBUG_INIT, "PCIe: Segment %u trained in %u us\n", Segment, TrainTimeUs[Segment]));
+        continue;
+      }
+
+      //
+      // Once the LTSSM leaves Detect a receiver is present, so give the
+      // link the full timeout regardless of what history says.
+      //
+      if ((LtssmStatus & SMLH_LTSSM_STATE_MASK) > SMLH_LTSSM_STATE_DETECT_ACT) {
+        Detected |= 1U << Segment;
+      }
+
+      if (  ((Detected & (1U << Segment)) == 0)
+         && (Elapsed >= PciGetLinkDetectTimeout (&History, Segment)))
+      {
+        DEBUG ((DEBUG_INIT, "PCIe: Segment %u: No device detected\n", Segment));
+        Pending &= ~(1U << Segment);
+        PERF_INMODULE_END (mPciHostPerfNames[Segment]);
+      }
+    }
+
+    if ((Pending == 0) || (Elapsed >= PCIE_LINK_UP_TIMEOUT_US)) {
       break;
     }
 
-    gBS->Stall (100000);
+    gBS->Stall (Interval);
+    Elapsed += Interval;
+    Interval = MIN (Interval * 2, PCIE_LINK_POLL_MAX_INTERVAL_US);
   }
 
-  if (Retry == 0) {
-    DEBUG ((DEBUG_WARN, "PCIe: Link up timeout!\n"));
-    return EFI_TIMEOUT;
+  for (Segment = 0; Segment < NUM_SEGMENTS; Segment++) {
+    if ((Pending & (1U << Segment)) != 0) {
+      DEBUG ((DEBUG_WARN, "PCIe: Segment %u: Link up timeout!\n", Segment));
+      PERF_INMODULE_END (mPciHostPerfNames[Segment]);
+    }
   }
 
-  PciGetLinkSpeedWidth (DbiBase, &LinkSpeed, &LinkWidth);
-  PciPrintLinkSpeedWidth (LinkSpeed, LinkWidth);
-
-  PciValidateCfg0 (Segment, PcieBase + Cfg0Base);
+  PciSaveLinkHistory (&History, *SegmentMask, LinkUp, TrainTimeUs);
 
-  return EFI_SUCCESS;
+  *SegmentMask = LinkUp;
+  return (LinkUp != 0) ? EFI_SUCCESS : EFI_NOT_FOUND;
 }
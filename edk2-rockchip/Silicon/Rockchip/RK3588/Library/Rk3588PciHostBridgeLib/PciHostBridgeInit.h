@@ -11,8 +11,8 @@
 #define PCIHOSTBRIDGEINIT_H__
 
 EFI_STATUS
-InitializePciHost (
-  UINT32  Segment
+InitializePciHosts (
+  IN OUT UINT32  *SegmentMask
   );
 
 #endif /* PCIHOSTBRIDGEINIT_H__ */
@@ -163,17 +163,21 @@ PciHostBridgeGetRootBridges (
   UINTN  *Count
   )
 {
-  EFI_STATUS  Status;
-  UINTN       Idx;
-  UINTN       Loop;
+  UINTN   Idx;
+  UINTN   Loop;
+  UINT32  SegmentMask;
 
-  for (Idx = 0, Loop = 0; Idx < NUM_PCIE_CONTROLLER; Idx++) {
-    if (IsPcieNumEnabled (Idx) == FALSE) {
-      continue;
+  SegmentMask = 0;
+  for (Idx = 0; Idx < NUM_PCIE_CONTROLLER; Idx++) {
+    if (IsPcieNumEnabled (Idx)) {
+      SegmentMask |= 1U << Idx;
     }
+  }
 
-    Status = InitializePciHost (Idx);
-    if (EFI_ERROR (Status)) {
+  InitializePciHosts (&SegmentMask);
+
+  for (Idx = 0, Loop = 0; Idx < NUM_PCIE_CONTROLLER; Idx++) {
+    if ((SegmentMask & (1U << Idx)) == 0) {
       continue;
     }
 
@@ -14,6 +14,7 @@
 
 #include <Library/PciSegmentLib.h>
 #include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/IoLib.h>
 #include <Library/Rk3588Pcie.h>
@@ -42,6 +43,8 @@ typedef enum {
 #define GET_FUNC_NUM(Address)  ((Address >> 12) & 0x07)
 #define GET_REG_NUM(Address)   ((Address) & 0xFFF)
 
+#define PCI_CFG_GHOST_BASE  0xFFFFFFFF
+
 STATIC
 UINT64
 PciSegmentLibGetConfigBase (
@@ -63,7 +66,7 @@ PciSegmentLibGetConfigBase (
 
   // Ignore more than one device on bus 0 and 1 to hide duplicates/ghosts.
   if ((Device > 0) && ((Bus == 0) || (Bus == 1))) {
-    return 0xffffffff;
+    return PCI_CFG_GHOST_BASE;
   }
 
   // The root port is not part of the main config space.
@@ -96,7 +99,7 @@ PciSegmentLibReadWorker (
 
   Base = PciSegmentLibGetConfigBase (Address);
 
-  if (Base == 0xFFFFFFFF) {
+  if (Base == PCI_CFG_GHOST_BASE) {
     return Base;
   }
 
@@ -140,7 +143,7 @@ PciSegmentLibWriteWorker (
 
   Base = PciSegmentLibGetConfigBase (Address);
 
-  if (Base == 0xFFFFFFFF) {
+  if (Base == PCI_CFG_GHOST_BASE) {
     return Base;
   }
 
@@ -1251,7 +1254,9 @@ PciSegmentReadBuffer (
   OUT VOID    *Buffer
   )
 {
-  UINTN  ReturnValue;
+  UINTN   ReturnValue;
+  UINT64  Base;
+  UINT64  Address;
 
   ASSERT_INVALID_PCI_SEGMENT_ADDRESS (StartAddress, 0);
   ASSERT (((StartAddress & 0xFFF) + Size) <= 0x1000);
@@ -1267,51 +1272,63 @@ PciSegmentReadBuffer (
   //
   ReturnValue = Size;
 
-  if ((StartAddress & BIT0) != 0) {
+  //
+  // The whole range belongs to a single function, so route it once and
+  // access the MMIO window directly.
+  //
+  Base = PciSegmentLibGetConfigBase (StartAddress);
+  if (Base == PCI_CFG_GHOST_BASE) {
+    SetMem (Buffer, Size, 0xFF);
+    return ReturnValue;
+  }
+
+  Address = Base + (UINT32)StartAddress;
+
+  if ((Address & BIT0) != 0) {
     //
     // Read a byte if StartAddress is byte aligned
     //
-    *(volatile UINT8 *)Buffer = PciSegmentRead8 (StartAddress);
-    StartAddress             += sizeof (UINT8);
+    *(volatile UINT8 *)Buffer = MmioRead8 (Address);
+    Address                  += sizeof (UINT8);
     Size                     -= sizeof (UINT8);
     Buffer                    = (UINT8 *)Buffer + 1;
   }
 
-  if ((Size >= sizeof (UINT16)) && ((StartAddress & BIT1) != 0)) {
+  if ((Size >= sizeof (UINT16)) && ((Address & BIT1) != 0)) {
     //
     // Read a word if StartAddress is word aligned
     //
-    WriteUnaligned16 (Buffer, PciSegmentRead16 (StartAddress));
-    StartAddress += sizeof (UINT16);
-    Size         -= sizeof (UINT16);
-    Buffer        = (UINT16 *)Buffer + 1;
+    WriteUnaligned16 (Buffer, MmioRead16 (Address));
+    Address += sizeof (UINT16);
+    Size    -= sizeof (UINT16);
+    Buffer   = (UINT16 *)Buffer + 1;
   }
 
   while (Size >= sizeof (UINT32)) {
     //
     // Read as many double words as possible
     //
-    WriteUnaligned32 (Buffer, PciSegmentRead32 (StartAddress));
-    StartAddress += sizeof (UINT32);
-    Size         -= sizeof (UINT32);
-    Buffer        = (UINT32 *)Buffer + 1;
+    WriteUnaligned32 (Buffer, MmioRead32 (Address));
+    Address += sizeof (UINT32);
+    Size    -= sizeof (UINT32);
+    Buffer   = (UINT32 *)Buffer + 1;
   }
 
   if (Size >= sizeof (UINT16)) {
     //
     // Read the last remaining word if exist
     //
-    WriteUnaligned16 (Buffer, PciSegmentRead16 (StartAddress));
-    StartAddress += sizeof (UINT16);
-    Size         -= sizeof (UINT16);
-    Buffer        = (UINT16 *)Buffer + 1;
+    WriteUnaligned16 (Buffer, MmioRead16 (Address));
+    Address += sizeof (UINT16);
+    Size    -= sizeof (UINT16);
+    Buffer   = (UINT16 *)Buffer + 1;
   }
 
   if (Size >= sizeof (UINT8)) {
     //
     // Read the last remaining byte if exist
     //
-    *(volatile UINT8 *)Buffer = PciSegmentRead8 (StartAddress);
+    *(volatile UINT8 *)Buffer = MmioRead8 (Address);
   }
 
   return ReturnValue;
@@ -1349,7 +1366,9 @@ PciSegmentWriteBuffer (
   IN VOID    *Buffer
   )
 {
-  UINTN  ReturnValue;
+  UINTN   ReturnValue;
+  UINT64  Base;
+  UINT64  Address;
 
   ASSERT_INVALID_PCI_SEGMENT_ADDRESS (StartAddress, 0);
   ASSERT (((StartAddress & 0xFFF) + Size) <= 0x1000);
@@ -1365,51 +1384,58 @@ PciSegmentWriteBuffer (
   //
   ReturnValue = Size;
 
-  if ((StartAddress & BIT0) != 0) {
+  Base = PciSegmentLibGetConfigBase (StartAddress);
+  if (Base == PCI_CFG_GHOST_BASE) {
+    return ReturnValue;
+  }
+
+  Address = Base + (UINT32)StartAddress;
+
+  if ((Address & BIT0) != 0) {
     //
     // Write a byte if StartAddress is byte aligned
     //
-    PciSegmentWrite8 (StartAddress, *(UINT8 *)Buffer);
-    StartAddress += sizeof (UINT8);
-    Size         -= sizeof (UINT8);
-    Buffer        = (UINT8 *)Buffer + 1;
+    MmioWrite8 (Address, *(UINT8 *)Buffer);
+    Address += sizeof (UINT8);
+    Size    -= sizeof (UINT8);
+    Buffer   = (UINT8 *)Buffer + 1;
   }
 
-  if ((Size >= sizeof (UINT16)) && ((StartAddress & BIT1) != 0)) {
+  if ((Size >= sizeof (UINT16)) && ((Address & BIT1) != 0)) {
     //
     // Write a word if StartAddress is word aligned
     //
-    PciSegmentWrite16 (StartAddress, ReadUnaligned16 (Buffer));
-    StartAddress += sizeof (UINT16);
-    Size         -= sizeof (UINT16);
-    Buffer        = (UINT16 *)Buffer + 1;
+    MmioWrite16 (Address, ReadUnaligned16 (Buffer));
+    Address += sizeof (UINT16);
+    Size    -= sizeof (UINT16);
+    Buffer   = (UINT16 *)Buffer + 1;
   }
 
   while (Size >= sizeof (UINT32)) {
     //
     // Write as many double words as possible
     //
-    PciSegmentWrite32 (StartAddress, ReadUnaligned32 (Buffer));
-    StartAddress += sizeof (UINT32);
-    Size         -= sizeof (UINT32);
-    Buffer        = (UINT32 *)Buffer + 1;
+    MmioWrite32 (Address, ReadUnaligned32 (Buffer));
+    Address += sizeof (UINT32);
+    Size    -= sizeof (UINT32);
+    Buffer   = (UINT32 *)Buffer + 1;
   }
 
   if (Size >= sizeof (UINT16)) {
     //
     // Write the last remaining word if exist
     //
-    PciSegmentWrite16 (StartAddress, ReadUnaligned16 (Buffer));
-    StartAddress += sizeof (UINT16);
-    Size         -= sizeof (UINT16);
-    Buffer        = (UINT16 *)Buffer + 1;
+    MmioWrite16 (Address, ReadUnaligned16 (Buffer));
+    Address += sizeof (UINT16);
+    Size    -= sizeof (UINT16);
+    Buffer   = (UINT16 *)Buffer + 1;
   }
 
   if (Size >= sizeof (UINT8)) {
     //
     // Write the last remaining byte if exist
     //
-    PciSegmentWrite8 (StartAddress, *(UINT8 *)Buffer);
+    MmioWrite8 (Address, *(UINT8 *)Buffer);
   }
 
   return ReturnValue;
@@ -15,6 +15,7 @@
 #include <Library/DevicePathLib.h>
 #include <Library/IoLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
 #include <Protocol/NonDiscoverableDevice.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiDriverEntryPoint.h>
@@ -57,6 +58,9 @@ DW_MMC_HC_PRIVATE_DATA  gDwMmcHcTemplate = {
   NULL,                                                  // ConnectEvent
                                                          // Queue
   INITIALIZE_LIST_HEAD_VARIABLE (gDwMmcHcTemplate.Queue),
+  NULL,                                                  // DmaDescPool
+  0,                                                     // DmaDescPoolPhy
+  NULL,                                                  // DmaDescPoolMap
   {                                 // Slot
     { 0,                                                 UnknownSlot,0, 0, 0 }
   },
@@ -66,7 +70,12 @@ DW_MMC_HC_PRIVATE_DATA  gDwMmcHcTemplate = {
   {                                 // MaxCurrent
     0
   },
-  0                                 // ControllerVersion
+  0,                                // ControllerVersion
+  NULL,                             // ReadAheadBuffer
+  0,                                // ReadAheadLba
+  0,                                // ReadAheadBlocks
+  0,                                // ReadAheadNextLba
+  { 0 }                             // ReadAheadStatusBlk
 };
 
 SD_DEVICE_PATH  mSdDpTemplate = {
@@ -281,6 +290,7 @@ DwMmcHcEnumerateDevice (
         Private->DevBase
         ));
       Private->Slot[0].MediaPresent = FALSE;
+      Private->ReadAheadBlocks      = 0;
       //
       // Signal all async task events at the slot with EFI_NO_MEDIA status.
       //
@@ -683,6 +693,14 @@ DwMmcHcDriverBindingStart (
   Private->Slot[0].CardType = Private->Capability[0].CardType;
   Private->Slot[0].Enable   = TRUE;
 
+  if (DW_MMC_HC_READ_AHEAD_BLOCKS != 0) {
+    //
+    // Read-ahead is optional, carry on without it if this fails.
+    //
+    Private->ReadAheadBuffer = AllocatePool (DW_MMC_HC_READ_AHEAD_BLOCKS * DW_MMC_BLOCK_SIZE);
+  }
+
+  PERF_INMODULE_BEGIN ("DwMmcCardInit");
   RoutineNum = sizeof (mCardTypeDetectRoutineTable) / sizeof (DWMMC_CARD_TYPE_DETECT_ROUTINE);
   for (Index = 0; Index < RoutineNum; Index++) {
     Routine = &mCardTypeDetectRoutineTable[Index];
@@ -694,6 +712,8 @@ DwMmcHcDriverBindingStart (
     }
   }
 
+  PERF_INMODULE_END ("DwMmcCardInit");
+
   //
   // Start the asynchronous I/O monitor
   //
@@ -752,6 +772,11 @@ Done:
     }
 
     if (Private != NULL) {
+      DwMmcHcFreeDmaDescPool (Private);
+      if (Private->ReadAheadBuffer != NULL) {
+        FreePool (Private->ReadAheadBuffer);
+      }
+
       FreePool (Private);
     }
   }
@@ -871,6 +896,11 @@ DwMmcHcDriverBindingStop (
          Controller
          );
 
+  DwMmcHcFreeDmaDescPool (Private);
+  if (Private->ReadAheadBuffer != NULL) {
+    FreePool (Private->ReadAheadBuffer);
+  }
+
   FreePool (Private);
 
   DEBUG ((DEBUG_INFO, "DwMmcHcDriverBindingStop: End with %r\n", Status));
@@ -878,6 +908,182 @@ DwMmcHcDriverBindingStop (
   return Status;
 }
 
+/**
+  Execute a SD command packet synchronously.
+
+  @param[in]     Private        A pointer to the DW_MMC_HC_PRIVATE_DATA
+                                instance.
+  @param[in]     Slot           The slot number of the SD card to send the
+                                command to.
+  @param[in,out] Packet         A pointer to the SD command data structure.
+
+  @retval EFI_SUCCESS           The packet was executed successfully.
+  @retval Others                The packet failed.
+
+**/
+STATIC
+EFI_STATUS
+DwMmcExecPacket (
+  IN     DW_MMC_HC_PRIVATE_DATA               *Private,
+  IN     UINT8                                Slot,
+  IN OUT EFI_SD_MMC_PASS_THRU_COMMAND_PACKET  *Packet
+  )
+{
+  EFI_STATUS     Status;
+  DW_MMC_HC_TRB  *Trb;
+  EFI_TPL        OldTpl;
+
+  Trb = DwMmcCreateTrb (Private, Slot, Packet, NULL);
+  if (Trb == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Wait async I/O list is empty before execute sync I/O operation.
+  //
+  while (TRUE) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    if (IsListEmpty (&Private->Queue)) {
+      gBS->RestoreTPL (OldTpl);
+      break;
+    }
+
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  Status = DwMmcWaitTrbEnv (Private, Trb);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  Status = DwMmcExecTrb (Private, Trb);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  Status = DwMmcWaitTrbResult (Private, Trb);
+
+Done:
+  DwMmcFreeTrb (Trb);
+
+  return Status;
+}
+
+/**
+  Complete a blocking SD card read through the read-ahead buffer.
+
+  Reads covered by the buffer are copied out of it. A read that starts
+  where the previous one ended is widened to DW_MMC_HC_READ_AHEAD_BLOCKS,
+  or to the end of the card, and the surplus is kept for the next reads.
+
+  @param[in]     Private        A pointer to the DW_MMC_HC_PRIVATE_DATA
+                                instance.
+  @param[in]     Slot           The slot number of the SD card.
+  @param[in,out] Packet         A pointer to the SD command data structure.
+
+  @retval EFI_SUCCESS           The read was completed.
+  @retval EFI_NOT_FOUND         The read must be sent to the card as is.
+
+**/
+STATIC
+EFI_STATUS
+DwMmcReadAhead (
+  IN     DW_MMC_HC_PRIVATE_DATA               *Private,
+  IN     UINT8                                Slot,
+  IN OUT EFI_SD_MMC_PASS_THRU_COMMAND_PACKET  *Packet
+  )
+{
+  EFI_STATUS                           Status;
+  EFI_SD_MMC_PASS_THRU_COMMAND_PACKET  FillPacket;
+  EFI_SD_MMC_COMMAND_BLOCK             FillCmdBlk;
+  EFI_SD_MMC_STATUS_BLOCK              FillStatusBlk;
+  UINT64                               Lba;
+  UINT64                               Blocks;
+  UINT64                               Window;
+  BOOLEAN                              Sequential;
+
+  if ((Packet->InTransferLength == 0) ||
+      ((Packet->InTransferLength % DW_MMC_BLOCK_SIZE) != 0))
+  {
+    return EFI_NOT_FOUND;
+  }
+
+  Lba = Packet->SdMmcCmdBlk->CommandArgument;
+  if (!Private->Slot[Slot].HighCapacity) {
+    Lba /= DW_MMC_BLOCK_SIZE;
+  }
+
+  Blocks = Packet->InTransferLength / DW_MMC_BLOCK_SIZE;
+
+  if ((Lba >= Private->ReadAheadLba) &&
+      (Lba + Blocks <= (UINT64)Private->ReadAheadLba + Private->ReadAheadBlocks))
+  {
+    CopyMem (
+      Packet->InDataBuffer,
+      Private->ReadAheadBuffer + (Lba - Private->ReadAheadLba) * DW_MMC_BLOCK_SIZE,
+      Packet->InTransferLength
+      );
+    CopyMem (Packet->SdMmcStatusBlk, &Private->ReadAheadStatusBlk, sizeof (EFI_SD_MMC_STATUS_BLOCK));
+    Private->ReadAheadNextLba = (UINT32)(Lba + Blocks);
+    return EFI_SUCCESS;
+  }
+
+  Sequential                = (Lba == Private->ReadAheadNextLba);
+  Private->ReadAheadNextLba = (UINT32)(Lba + Blocks);
+
+  //
+  // Never read past the end of the card.
+  //
+  if (Lba >= Private->Slot[Slot].BlockCount) {
+    return EFI_NOT_FOUND;
+  }
+
+  Window = MIN (DW_MMC_HC_READ_AHEAD_BLOCKS, Private->Slot[Slot].BlockCount - Lba);
+
+  if (!Sequential || (Blocks >= Window)) {
+    return EFI_NOT_FOUND;
+  }
+
+  //
+  // Byte addresses of standard capacity cards must fit the argument.
+  //
+  if (Lba + Window >
+      (Private->Slot[Slot].HighCapacity ? MAX_UINT32 : MAX_UINT32 / DW_MMC_BLOCK_SIZE))
+  {
+    return EFI_NOT_FOUND;
+  }
+
+  CopyMem (&FillCmdBlk, Packet->SdMmcCmdBlk, sizeof (FillCmdBlk));
+  FillCmdBlk.CommandIndex    = SD_READ_MULTIPLE_BLOCK;
+  FillCmdBlk.CommandArgument = Private->Slot[Slot].HighCapacity ?
+                               (UINT32)Lba : (UINT32)Lba * DW_MMC_BLOCK_SIZE;
+
+  ZeroMem (&FillStatusBlk, sizeof (FillStatusBlk));
+  ZeroMem (&FillPacket, sizeof (FillPacket));
+  FillPacket.SdMmcCmdBlk      = &FillCmdBlk;
+  FillPacket.SdMmcStatusBlk   = &FillStatusBlk;
+  FillPacket.Timeout          = Packet->Timeout;
+  FillPacket.InDataBuffer     = Private->ReadAheadBuffer;
+  FillPacket.InTransferLength = (UINT32)Window * DW_MMC_BLOCK_SIZE;
+
+  Private->ReadAheadBlocks = 0;
+
+  Status = DwMmcExecPacket (Private, Slot, &FillPacket);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "%a: Read-ahead at LBA 0x%lx failed. Status=%r\n", __func__, Lba, Status));
+    return EFI_NOT_FOUND;
+  }
+
+  Private->ReadAheadLba    = (UINT32)Lba;
+  Private->ReadAheadBlocks = (UINT32)Window;
+  CopyMem (&Private->ReadAheadStatusBlk, &FillStatusBlk, sizeof (FillStatusBlk));
+
+  CopyMem (Packet->InDataBuffer, Private->ReadAheadBuffer, Packet->InTransferLength);
+  CopyMem (Packet->SdMmcStatusBlk, &FillStatusBlk, sizeof (FillStatusBlk));
+
+  return EFI_SUCCESS;
+}
+
 /**
   Sends SD command to an SD card that is attached to the SD controller.
 
@@ -933,7 +1139,6 @@ DwMmcPassThruPassThru (
   EFI_STATUS              Status;
   DW_MMC_HC_PRIVATE_DATA  *Private;
   DW_MMC_HC_TRB           *Trb;
-  EFI_TPL                 OldTpl;
 
   if ((This == NULL) || (Packet == NULL)) {
     return EFI_INVALID_PARAMETER;
@@ -961,52 +1166,45 @@ DwMmcPassThruPassThru (
     return EFI_NO_MEDIA;
   }
 
-  Trb = DwMmcCreateTrb (Private, Slot, Packet, Event);
-  if (Trb == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+  if ((Private->ReadAheadBuffer != NULL) &&
+      (Private->Slot[Slot].CardType == SdCardType))
+  {
+    switch (Packet->SdMmcCmdBlk->CommandIndex) {
+      case SD_READ_SINGLE_BLOCK:
+      case SD_READ_MULTIPLE_BLOCK:
+        if (Event == NULL) {
+          Status = DwMmcReadAhead (Private, Slot, Packet);
+          if (Status != EFI_NOT_FOUND) {
+            return Status;
+          }
+        }
+
+        break;
+      case SD_SEND_STATUS:
+        break;
+      default:
+        //
+        // Writes, erases and anything that may reinitialize the card
+        // make the buffered data stale.
+        //
+        Private->ReadAheadBlocks = 0;
+        break;
+    }
   }
 
   //
   // Immediately return for async I/O.
   //
   if (Event != NULL) {
-    return EFI_SUCCESS;
-  }
-
-  //
-  // Wait async I/O list is empty before execute sync I/O operation.
-  //
-  while (TRUE) {
-    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
-    if (IsListEmpty (&Private->Queue)) {
-      gBS->RestoreTPL (OldTpl);
-      break;
+    Trb = DwMmcCreateTrb (Private, Slot, Packet, Event);
+    if (Trb == NULL) {
+      return EFI_OUT_OF_RESOURCES;
     }
 
-    gBS->RestoreTPL (OldTpl);
-  }
-
-  Status = DwMmcWaitTrbEnv (Private, Trb);
-  if (EFI_ERROR (Status)) {
-    goto Done;
-  }
-
-  Status = DwMmcExecTrb (Private, Trb);
-  if (EFI_ERROR (Status)) {
-    goto Done;
-  }
-
-  Status = DwMmcWaitTrbResult (Private, Trb);
-  if (EFI_ERROR (Status)) {
-    goto Done;
-  }
-
-Done:
-  if (Trb != NULL) {
-    DwMmcFreeTrb (Trb);
+    return EFI_SUCCESS;
   }
 
-  return Status;
+  return DwMmcExecPacket (Private, Slot, Packet);
 }
 
 /**
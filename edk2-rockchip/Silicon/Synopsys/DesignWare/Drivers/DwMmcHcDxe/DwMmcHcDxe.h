@@ -14,6 +14,7 @@
 
 #include <Uefi.h>
 
+#include <Library/PerformanceLib.h>
 #include <Library/UefiLib.h>
 
 #include <Protocol/ComponentName.h>
@@ -49,12 +50,35 @@ extern EFI_DRIVER_BINDING_PROTOCOL   gDwMmcHcDriverBinding;
 //
 #define DW_MMC_HC_ENUM_TIMER  EFI_TIMER_PERIOD_MILLISECONDS(100)
 
+//
+// DMA descriptors preallocated per controller, enough to cover the largest
+// transfer issued by EmmcDxe and SdDxe (65535 blocks).
+//
+#define DW_MMC_HC_DMA_DESC_POOL_ENTRIES \
+  ((0xFFFF * DW_MMC_BLOCK_SIZE + DWMMC_DMA_BUF_SIZE - 1) / DWMMC_DMA_BUF_SIZE)
+#define DW_MMC_HC_DMA_DESC_POOL_PAGES \
+  EFI_SIZE_TO_PAGES (DW_MMC_HC_DMA_DESC_POOL_ENTRIES * sizeof (DW_MMC_HC_DMA_DESC_LINE))
+
+//
+// Blocks read from SD cards when a read continues the previous one,
+// 0 to disable read-ahead.
+//
+#define DW_MMC_HC_READ_AHEAD_BLOCKS  FixedPcdGet32 (PcdDwMmcHcReadAheadBlocks)
+
 typedef struct {
   BOOLEAN                 Enable;
   EFI_SD_MMC_SLOT_TYPE    SlotType;
   BOOLEAN                 MediaPresent;
   BOOLEAN                 Initialized;
   SD_MMC_CARD_TYPE        CardType;
+  //
+  // SD cards addressed in blocks rather than bytes (OCR.CCS set).
+  //
+  BOOLEAN                 HighCapacity;
+  //
+  // SD card capacity in blocks, from the CSD.
+  //
+  UINT64                  BlockCount;
 } DW_MMC_HC_SLOT;
 
 typedef struct {
@@ -81,12 +105,29 @@ typedef struct {
   //
   EFI_EVENT                        ConnectEvent;
   LIST_ENTRY                       Queue;
+  //
+  // DMA descriptor table shared by the TRBs of this controller, allocated
+  // on the first IDMAC transfer.
+  //
+  DW_MMC_HC_DMA_DESC_LINE          *DmaDescPool;
+  EFI_PHYSICAL_ADDRESS             DmaDescPoolPhy;
+  VOID                             *DmaDescPoolMap;
 
   DW_MMC_HC_SLOT                   Slot[DW_MMC_HC_MAX_SLOT];
   DW_MMC_HC_SLOT_CAP               Capability[DW_MMC_HC_MAX_SLOT];
   UINT64                           MaxCurrent[DW_MMC_HC_MAX_SLOT];
 
   UINT32                           ControllerVersion;
+  //
+  // Read-ahead buffer for sequential SD card reads. It holds
+  // ReadAheadBlocks blocks starting at ReadAheadLba, read with
+  // ReadAheadStatusBlk as the card's response.
+  //
+  UINT8                            *ReadAheadBuffer;
+  UINT32                           ReadAheadLba;
+  UINT32                           ReadAheadBlocks;
+  UINT32                           ReadAheadNextLba;
+  EFI_SD_MMC_STATUS_BLOCK          ReadAheadStatusBlk;
 } DW_MMC_HC_PRIVATE_DATA;
 
 #define DW_MMC_HC_TRB_SIG  SIGNATURE_32 ('D', 'T', 'R', 'B')
@@ -694,6 +735,31 @@ DwMmcFreeTrb (
   IN DW_MMC_HC_TRB  *Trb
   );
 
+/**
+  Allocate the DMA descriptor pool used for the transfers of a controller.
+
+  @param[in] Private        A pointer to the DW_MMC_HC_PRIVATE_DATA instance.
+
+  @retval EFI_SUCCESS       The pool is allocated.
+  @retval Others            The pool can't be allocated.
+
+**/
+EFI_STATUS
+DwMmcHcAllocateDmaDescPool (
+  IN DW_MMC_HC_PRIVATE_DATA  *Private
+  );
+
+/**
+  Free the DMA descriptor pool of a controller.
+
+  @param[in] Private        A pointer to the DW_MMC_HC_PRIVATE_DATA instance.
+
+**/
+VOID
+DwMmcHcFreeDmaDescPool (
+  IN DW_MMC_HC_PRIVATE_DATA  *Private
+  );
+
 /**
   Check if the env is ready for execute specified TRB.
 
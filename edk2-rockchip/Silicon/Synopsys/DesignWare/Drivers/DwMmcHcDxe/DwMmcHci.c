@@ -661,6 +661,116 @@ DwMmcHcStopDma (
   return EFI_SUCCESS;
 }
 
+/**
+  Allocate and map a DMA descriptor table that the IDMAC can address.
+
+  @param[in]  Pages         The size of the table in pages.
+  @param[out] DmaDesc       The host address of the table.
+  @param[out] DmaDescPhy    The device address of the table.
+  @param[out] DmaMap        The mapping of the table.
+
+  @retval EFI_SUCCESS           The table is allocated and mapped.
+  @retval EFI_OUT_OF_RESOURCES  The table can't be allocated or mapped.
+  @retval EFI_DEVICE_ERROR      The table isn't below 4 GiB.
+
+**/
+STATIC
+EFI_STATUS
+AllocateDmaDescTable (
+  IN  UINTN                    Pages,
+  OUT DW_MMC_HC_DMA_DESC_LINE  **DmaDesc,
+  OUT EFI_PHYSICAL_ADDRESS     *DmaDescPhy,
+  OUT VOID                     **DmaMap
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Bytes;
+
+  Status = DmaAllocateBuffer (EfiBootServicesData, Pages, (VOID **)DmaDesc);
+  if (EFI_ERROR (Status)) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Bytes  = EFI_PAGES_TO_SIZE (Pages);
+  Status = DmaMap (
+             MapOperationBusMasterCommonBuffer,
+             *DmaDesc,
+             &Bytes,
+             DmaDescPhy,
+             DmaMap
+             );
+  if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (Pages))) {
+    if (!EFI_ERROR (Status)) {
+      DmaUnmap (*DmaMap);
+    }
+
+    DmaFreeBuffer (Pages, *DmaDesc);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // The DMA doesn't support 64bit addressing.
+  //
+  if ((*DmaDescPhy + Bytes) > 0x100000000ul) {
+    DmaUnmap (*DmaMap);
+    DmaFreeBuffer (Pages, *DmaDesc);
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Allocate the DMA descriptor pool used for the transfers of a controller.
+
+  @param[in] Private        A pointer to the DW_MMC_HC_PRIVATE_DATA instance.
+
+  @retval EFI_SUCCESS       The pool is allocated.
+  @retval Others            The pool can't be allocated.
+
+**/
+EFI_STATUS
+DwMmcHcAllocateDmaDescPool (
+  IN DW_MMC_HC_PRIVATE_DATA  *Private
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = AllocateDmaDescTable (
+             DW_MMC_HC_DMA_DESC_POOL_PAGES,
+             &Private->DmaDescPool,
+             &Private->DmaDescPoolPhy,
+             &Private->DmaDescPoolMap
+             );
+  if (EFI_ERROR (Status)) {
+    Private->DmaDescPool    = NULL;
+    Private->DmaDescPoolMap = NULL;
+  }
+
+  return Status;
+}
+
+/**
+  Free the DMA descriptor pool of a controller.
+
+  @param[in] Private        A pointer to the DW_MMC_HC_PRIVATE_DATA instance.
+
+**/
+VOID
+DwMmcHcFreeDmaDescPool (
+  IN DW_MMC_HC_PRIVATE_DATA  *Private
+  )
+{
+  if (Private->DmaDescPool == NULL) {
+    return;
+  }
+
+  DmaUnmap (Private->DmaDescPoolMap);
+  DmaFreeBuffer (DW_MMC_HC_DMA_DESC_POOL_PAGES, Private->DmaDescPool);
+  Private->DmaDescPool    = NULL;
+  Private->DmaDescPoolMap = NULL;
+}
+
 /**
   Build DMA descriptor table for transfer.
 
@@ -683,7 +793,6 @@ BuildDmaDescTable (
   UINTN                    TableSize;
   UINTN                    DevBase;
   EFI_STATUS               Status;
-  UINTN                    Bytes;
   UINTN                    Blocks;
   DW_MMC_HC_DMA_DESC_LINE  *DmaDesc;
   UINT32                   DmaDescPhy;
@@ -717,69 +826,44 @@ BuildDmaDescTable (
   TableSize = Entries * sizeof (DW_MMC_HC_DMA_DESC_LINE);
   Blocks    = (DataLen + DW_MMC_BLOCK_SIZE - 1) / DW_MMC_BLOCK_SIZE;
 
-  Trb->DmaDescPages = (UINT32)EFI_SIZE_TO_PAGES (Entries * DWMMC_DMA_BUF_SIZE);
-
-  /*  Status = DevIo->AllocateBuffer (
-                      DevIo,
-                      AllocateAnyPages,
-                      EfiBootServicesData,
-                      EFI_SIZE_TO_PAGES (TableSize),
-                      (EFI_PHYSICAL_ADDRESS *)&Trb->DmaDesc
-                      );*/
-  Status = DmaAllocateBuffer (
-             EfiBootServicesData,
-             EFI_SIZE_TO_PAGES (TableSize),
-             (VOID *)&Trb->DmaDesc
-             );
-  if (EFI_ERROR (Status)) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  ZeroMem (Trb->DmaDesc, TableSize);
-  Bytes = TableSize;
-
-  Status = DmaMap (
-             MapOperationBusMasterCommonBuffer,
-             (EFI_PHYSICAL_ADDRESS *)Trb->DmaDesc,
-             &Bytes,
-             &Trb->DmaDescPhy,
-             &Trb->DmaMap
-             );
-
-  /*  Status = DevIo->Map (
-                      DevIo,
-                      EfiBusMasterCommonBuffer,
-                      (EFI_PHYSICAL_ADDRESS *)Trb->DmaDesc,
-                      &Bytes,
-                      &Trb->DmaDescPhy,
-                      &Trb->DmaMap
-                      );*/
-
-  if (EFI_ERROR (Status) || (Bytes != TableSize)) {
-    //
-    // Map error or unable to map the whole RFis buffer into a contiguous
-    // region.
-    //
-
-    /*    DevIo->FreeBuffer (
-                 DevIo,
-                 EFI_SIZE_TO_PAGES (TableSize),
-                 (EFI_PHYSICAL_ADDRESS)Trb->DmaDesc
-                 );*/
-    return EFI_OUT_OF_RESOURCES;
+  //
+  // SD cards go through the FIFO, so the pool is only allocated once the
+  // first IDMAC transfer is built. If that fails, use a table per TRB.
+  //
+  if ((Trb->Private->DmaDescPool == NULL) &&
+      (Entries <= DW_MMC_HC_DMA_DESC_POOL_ENTRIES))
+  {
+    Status = DwMmcHcAllocateDmaDescPool (Trb->Private);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "%a: Failed to allocate DMA descriptor pool. Status=%r\n", __func__, Status));
+    }
   }
 
-  if ((UINT64)(UINTN)Trb->DmaDescPhy > 0x100000000ul) {
+  if ((Trb->Private->DmaDescPool != NULL) &&
+      (Entries <= DW_MMC_HC_DMA_DESC_POOL_ENTRIES))
+  {
     //
-    // The DMA doesn't support 64bit addressing.
+    // The controller is programmed for one TRB at a time, so the table
+    // can always be built in the per-controller pool.
     //
-    DmaUnmap (Trb->DmaMap);
-
-    /*    DevIo->Unmap (
-          DevIo,
-          Trb->DmaMap
-        );*/
-    return EFI_DEVICE_ERROR;
+    Trb->DmaDesc      = Trb->Private->DmaDescPool;
+    Trb->DmaDescPhy   = Trb->Private->DmaDescPoolPhy;
+    Trb->DmaDescPages = 0;
+    Trb->DmaMap       = NULL;
+  } else {
+    Trb->DmaDescPages = (UINT32)EFI_SIZE_TO_PAGES (TableSize);
+    Status            = AllocateDmaDescTable (
+                          Trb->DmaDescPages,
+                          &Trb->DmaDesc,
+                          &Trb->DmaDescPhy,
+                          &Trb->DmaMap
+                          );
+    if (EFI_ERROR (Status)) {
+      Trb->DmaDesc      = NULL;
+      Trb->DmaDescPages = 0;
+      Trb->DmaMap       = NULL;
+      return Status;
+    }
   }
 
   if (DataLen < DW_MMC_BLOCK_SIZE) {
@@ -1103,6 +1187,10 @@ DwMmcFreeTrb (
     DmaUnmap (Trb->DmaMap);
   }
 
+  if (Trb->DmaDescPages != 0) {
+    DmaFreeBuffer (Trb->DmaDescPages, Trb->DmaDesc);
+  }
+
   if (Trb->DataMap != NULL) {
     DmaUnmap (Trb->DataMap);
   }
@@ -956,6 +956,7 @@ SdCardIdentification (
   UINT64                         MaxCurrent;
   SD_SCR                         Scr;
   SD_CSD                         Csd;
+  SD_CSD2                        *Csd2;
   BOOLEAN                        SdVersion1;
 
   DevBase    = Private->DevBase;
@@ -1050,6 +1051,8 @@ SdCardIdentification (
     }
   } while ((Ocr & BIT31) == 0);
 
+  Private->Slot[0].HighCapacity = (Ocr & BIT30) != 0;
+
   Status = SdCardAllSendCid (PassThru);
   if (EFI_ERROR (Status)) {
     DEBUG ((
@@ -1080,6 +1083,16 @@ SdCardIdentification (
     return Status;
   }
 
+  if (Csd.CsdStructure == 0) {
+    Private->Slot[0].BlockCount = (UINT64)((Csd.CSizeHigh << 2 | Csd.CSizeLow) + 1) *
+                                  (1 << (Csd.CSizeMul + 2)) *
+                                  (1 << Csd.ReadBlLen) / DW_MMC_BLOCK_SIZE;
+  } else {
+    Csd2                        = (SD_CSD2 *)(VOID *)&Csd;
+    Private->Slot[0].BlockCount = (UINT64)((Csd2->CSizeHigh << 16 | Csd2->CSizeLow) + 1) *
+                                  (SIZE_512KB / DW_MMC_BLOCK_SIZE);
+  }
+
   Status = SdCardSelect (PassThru, Rca);
   if (EFI_ERROR (Status)) {
     DEBUG ((
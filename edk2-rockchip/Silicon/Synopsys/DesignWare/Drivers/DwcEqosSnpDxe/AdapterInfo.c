@@ -8,6 +8,35 @@
 
 #include "Eqos.h"
 
+STATIC CONST EFI_GUID  *mEqosAipSupportedTypes[] = {
+  &gEfiAdapterInfoMediaStateGuid,
+  &gDwcEqosAdapterInfoRingStateGuid,
+  &gDwcEqosAdapterInfoOffloadStateGuid,
+};
+
+/**
+  Fills in a snapshot of the DMA descriptor rings state.
+
+  @param[in]  Eqos        The driver private data.
+  @param[out] RingState   The ring state to fill in.
+
+**/
+STATIC
+VOID
+EqosGetRingState (
+  IN  EQOS_PRIVATE_DATA                 *Eqos,
+  OUT DWC_EQOS_ADAPTER_INFO_RING_STATE  *RingState
+  )
+{
+  RingState->TxRingSize       = EQOS_TX_DESC_COUNT;
+  RingState->TxQueued         = Eqos->TxQueued;
+  RingState->TxQueuedMax      = Eqos->TxQueuedMax;
+  RingState->TxRecyclePending = Eqos->TxRecycledCount;
+  RingState->TxRingFullStalls = Eqos->TxRingFullStalls;
+  RingState->RxRingSize       = EQOS_RX_DESC_COUNT;
+  RingState->RxPendingRefill  = Eqos->RxDirtyCount;
+}
+
 /**
   Returns the current state information for the adapter.
 
@@ -43,8 +72,10 @@ EqosAipGetInformation (
   OUT UINTN                             *InformationBlockSize
   )
 {
-  EFI_ADAPTER_INFO_MEDIA_STATE  *AdapterInfo;
-  EQOS_PRIVATE_DATA             *Eqos;
+  EFI_ADAPTER_INFO_MEDIA_STATE         *AdapterInfo;
+  DWC_EQOS_ADAPTER_INFO_RING_STATE     *RingState;
+  DWC_EQOS_ADAPTER_INFO_OFFLOAD_STATE  *OffloadState;
+  EQOS_PRIVATE_DATA                    *Eqos;
 
   if ((This == NULL) || (InformationBlock == NULL) ||
       (InformationBlockSize == NULL))
@@ -52,22 +83,55 @@ EqosAipGetInformation (
     return EFI_INVALID_PARAMETER;
   }
 
-  if (!CompareGuid (InformationType, &gEfiAdapterInfoMediaStateGuid)) {
-    return EFI_UNSUPPORTED;
+  Eqos = EQOS_PRIVATE_DATA_FROM_AIP_THIS (This);
+
+  if (CompareGuid (InformationType, &gEfiAdapterInfoMediaStateGuid)) {
+    AdapterInfo = AllocateZeroPool (sizeof (EFI_ADAPTER_INFO_MEDIA_STATE));
+    if (AdapterInfo == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    *InformationBlock     = AdapterInfo;
+    *InformationBlockSize = sizeof (EFI_ADAPTER_INFO_MEDIA_STATE);
+
+    AdapterInfo->MediaState = EqosUpdateLink (Eqos);
+
+    return EFI_SUCCESS;
   }
 
-  AdapterInfo = AllocateZeroPool (sizeof (EFI_ADAPTER_INFO_MEDIA_STATE));
-  if (AdapterInfo == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+  if (CompareGuid (InformationType, &gDwcEqosAdapterInfoRingStateGuid)) {
+    RingState = AllocateZeroPool (sizeof (DWC_EQOS_ADAPTER_INFO_RING_STATE));
+    if (RingState == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    *InformationBlock     = RingState;
+    *InformationBlockSize = sizeof (DWC_EQOS_ADAPTER_INFO_RING_STATE);
+
+    EqosGetRingState (Eqos, RingState);
+
+    return EFI_SUCCESS;
   }
 
-  *InformationBlock     = AdapterInfo;
-  *InformationBlockSize = sizeof (EFI_ADAPTER_INFO_MEDIA_STATE);
+  if (CompareGuid (InformationType, &gDwcEqosAdapterInfoOffloadStateGuid)) {
+    OffloadState = AllocateZeroPool (sizeof (DWC_EQOS_ADAPTER_INFO_OFFLOAD_STATE));
+    if (OffloadState == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
 
-  Eqos                    = EQOS_PRIVATE_DATA_FROM_AIP_THIS (This);
-  AdapterInfo->MediaState = EqosUpdateLink (Eqos);
+    *InformationBlock     = OffloadState;
+    *InformationBlockSize = sizeof (DWC_EQOS_ADAPTER_INFO_OFFLOAD_STATE);
 
-  return EFI_SUCCESS;
+    OffloadState->TxChecksumOffload      = Eqos->TxChecksumOffload;
+    OffloadState->RxChecksumOffload      = Eqos->RxChecksumOffload;
+    OffloadState->TcpSegmentationOffload = FALSE;
+    OffloadState->RxChecksumGoodFrames   = Eqos->RxChecksumGoodFrames;
+    OffloadState->RxChecksumErrorFrames  = Eqos->RxChecksumErrorFrames;
+
+    return EFI_SUCCESS;
+  }
+
+  return EFI_UNSUPPORTED;
 }
 
 /**
@@ -105,7 +169,10 @@ EqosAipSetInformation (
     return EFI_INVALID_PARAMETER;
   }
 
-  if (CompareGuid (InformationType, &gEfiAdapterInfoMediaStateGuid)) {
+  if (CompareGuid (InformationType, &gEfiAdapterInfoMediaStateGuid) ||
+      CompareGuid (InformationType, &gDwcEqosAdapterInfoRingStateGuid) ||
+      CompareGuid (InformationType, &gDwcEqosAdapterInfoOffloadStateGuid))
+  {
     return EFI_WRITE_PROTECTED;
   }
 
@@ -144,6 +211,7 @@ EqosAipGetSupportedTypes (
   )
 {
   EFI_GUID  *Guid;
+  UINTN     Index;
 
   if ((This == NULL) || (InfoTypesBuffer == NULL) ||
       (InfoTypesBufferCount == NULL))
@@ -151,15 +219,17 @@ EqosAipGetSupportedTypes (
     return EFI_INVALID_PARAMETER;
   }
 
-  Guid = AllocatePool (sizeof *Guid);
+  Guid = AllocatePool (sizeof *Guid * ARRAY_SIZE (mEqosAipSupportedTypes));
   if (Guid == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
 
-  CopyGuid (Guid, &gEfiAdapterInfoMediaStateGuid);
+  for (Index = 0; Index < ARRAY_SIZE (mEqosAipSupportedTypes); Index++) {
+    CopyGuid (&Guid[Index], mEqosAipSupportedTypes[Index]);
+  }
 
   *InfoTypesBuffer      = Guid;
-  *InfoTypesBufferCount = 1;
+  *InfoTypesBufferCount = ARRAY_SIZE (mEqosAipSupportedTypes);
 
   return EFI_SUCCESS;
 }
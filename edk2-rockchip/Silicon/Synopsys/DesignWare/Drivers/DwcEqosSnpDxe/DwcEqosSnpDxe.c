@@ -119,9 +119,12 @@ EqosDriverBindingStart (
   EQOS_PRIVATE_DATA  *Eqos;
   EFI_STATUS         Status;
 
+  PERF_INMODULE_BEGIN ("EqosStart");
+
   Eqos = AllocateZeroPool (sizeof (EQOS_PRIVATE_DATA));
   if (Eqos == NULL) {
     DEBUG ((DEBUG_ERROR, "%a: Failed to allocate device context!\n", __func__));
+    PERF_INMODULE_END ("EqosStart");
     return EFI_OUT_OF_RESOURCES;
   }
 
@@ -176,6 +179,8 @@ EqosDriverBindingStart (
 
   SetMem (&Eqos->SnpMode.BroadcastAddress, sizeof (EFI_MAC_ADDRESS), 0xFF);
 
+  EqosResetStatistics (Eqos);
+
   CopyMem (
     &Eqos->SnpMode.PermanentAddress,
     &Eqos->Platform->MacAddress,
@@ -194,6 +199,23 @@ EqosDriverBindingStart (
 
   EqosInitializeConfig (Eqos);
 
+  Status = gBS->CreateEvent (
+                  EVT_NOTIFY_WAIT,
+                  TPL_NOTIFY,
+                  EqosSnpWaitForPacketNotify,
+                  Eqos,
+                  &Eqos->Snp.WaitForPacket
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((
+      DEBUG_ERROR,
+      "%a: Failed to create WaitForPacket event. Status=%r\n",
+      __func__,
+      Status
+      ));
+    goto Free;
+  }
+
   Status = gBS->CreateEventEx (
                   EVT_NOTIFY_SIGNAL,
                   TPL_CALLBACK,
@@ -237,6 +259,7 @@ EqosDriverBindingStart (
   }
 
   Eqos->ControllerHandle = ControllerHandle;
+  PERF_INMODULE_END ("EqosStart");
   return EFI_SUCCESS;
 
 Free:
@@ -244,9 +267,14 @@ Free:
     gBS->CloseEvent (Eqos->ExitBootServicesEvent);
   }
 
+  if (Eqos->Snp.WaitForPacket != NULL) {
+    gBS->CloseEvent (Eqos->Snp.WaitForPacket);
+  }
+
   EqosDmaFree (Eqos);
   FreePool (Eqos);
 
+  PERF_INMODULE_END ("EqosStart");
   return Status;
 }
 
@@ -309,6 +337,7 @@ EqosDriverBindingStop (
   }
 
   gBS->CloseEvent (Eqos->ExitBootServicesEvent);
+  gBS->CloseEvent (Eqos->Snp.WaitForPacket);
 
   Status = EqosStop (Eqos);
   ASSERT_EFI_ERROR (Status);
@@ -17,9 +17,13 @@
 #include <Library/DmaLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/NetLib.h>
+#include <Library/PcdLib.h>
+#include <Library/PerformanceLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiLib.h>
 
+#include <Guid/DwcEqosAdapterInfo.h>
+
 #include <Protocol/AdapterInformation.h>
 #include <Protocol/ComponentName.h>
 #include <Protocol/ComponentName2.h>
@@ -29,11 +33,35 @@
 #include "EqosHw.h"
 
 //
-// XXX: Having more RX descriptors (e.g. 256) affects performance
-// and seems to lead to more TCP segments getting dropped.
+// XXX: Having more RX descriptors (e.g. 256) was seen to affect performance
+// and seemed to lead to more TCP segments getting dropped, back when the
+// ring was re-armed one descriptor at a time. Check for this again when
+// raising PcdDwcEqosRxDescCount.
+//
+#define EQOS_TX_DESC_COUNT  FixedPcdGet32 (PcdDwcEqosTxDescCount)
+#define EQOS_RX_DESC_COUNT  FixedPcdGet32 (PcdDwcEqosRxDescCount)
+
+//
+// Consumed RX descriptors are re-armed in batches of this size (or earlier,
+// when the ring runs idle), so that the tail pointer only gets bumped once
+// per batch instead of once per received frame.
 //
-#define EQOS_TX_DESC_COUNT  32
-#define EQOS_RX_DESC_COUNT  2
+#define EQOS_RX_REFILL_THRESHOLD  MAX (EQOS_RX_DESC_COUNT / 8, 1)
+
+//
+// RX descriptors are posted without IOC, so the receive interrupt status
+// is coalesced by the RX watchdog timer instead of firing on every frame.
+//
+#define EQOS_RX_WATCHDOG_USEC  50
+
+STATIC_ASSERT (
+  (EQOS_TX_DESC_COUNT >= 2) && (EQOS_TX_DESC_COUNT <= 1024),
+  "PcdDwcEqosTxDescCount out of range"
+  );
+STATIC_ASSERT (
+  (EQOS_RX_DESC_COUNT >= 2) && (EQOS_RX_DESC_COUNT <= 1024),
+  "PcdDwcEqosRxDescCount out of range"
+  );
 
 #define EQOS_DESC_ALIGN  sizeof (struct EQOS_DMA_DESCRIPTOR)
 
@@ -57,6 +85,12 @@
 //
 #define EQOS_RX_BUFFER_SIZE  ALIGN_VALUE (MAX_ETHERNET_FRAME_SIZE, EqosAxiBusWidth128)
 
+typedef enum {
+  EqosRxChecksumNotChecked,
+  EqosRxChecksumGood,
+  EqosRxChecksumBad
+} EQOS_RX_CHECKSUM_STATUS;
+
 typedef struct {
   UINT32                               Signature;
   EFI_HANDLE                           ControllerHandle;
@@ -77,8 +111,12 @@ typedef struct {
   UINT8                                *TxBuffers[EQOS_TX_DESC_COUNT];
   VOID                                 *TxBuffersMap[EQOS_TX_DESC_COUNT];
   UINT32                               TxQueued;
+  UINT32                               TxQueuedMax;
   UINT32                               TxNext;
   UINT32                               TxCurrent;
+  VOID                                 *TxRecycled[EQOS_TX_DESC_COUNT];
+  UINT32                               TxRecycledCount;
+  UINT64                               TxRingFullStalls;
 
   VOID                                 *RxDescs;
   VOID                                 *RxDescsMap;
@@ -86,8 +124,16 @@ typedef struct {
   EFI_PHYSICAL_ADDRESS                 RxBuffersAddr;
   VOID                                 *RxBuffersMap[EQOS_RX_DESC_COUNT];
   UINT32                               RxCurrent;
+  UINT32                               RxDirty;
+  UINT32                               RxDirtyCount;
 
   UINT32                               HwFeatures[4];
+  BOOLEAN                              TxChecksumOffload;
+  BOOLEAN                              RxChecksumOffload;
+  UINT64                               RxChecksumGoodFrames;
+  UINT64                               RxChecksumErrorFrames;
+
+  EFI_NETWORK_STATISTICS               Stats;
 
   EFI_PHYSICAL_ADDRESS                 Base;
 } EQOS_PRIVATE_DATA;
@@ -106,6 +152,13 @@ extern CONST EFI_ADAPTER_INFORMATION_PROTOCOL  gEqosAipTemplate;
 #define EQOS_RX_BUFFER(p, idx)  ((UINT8 *)(UINTN)(p)->RxBuffersAddr + EQOS_RX_BUFFER_SIZE * (idx))
 #define EQOS_DESC(buf, idx)     ((EQOS_DMA_DESCRIPTOR *)((UINTN)(buf) + EQOS_DESC_OFF ((idx))))
 
+VOID
+EFIAPI
+EqosSnpWaitForPacketNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  );
+
 EFI_STATUS
 EqosIdentify (
   IN EQOS_PRIVATE_DATA  *Eqos
@@ -141,6 +194,11 @@ EqosDmaInitDescriptorRings (
   IN EQOS_PRIVATE_DATA  *Eqos
   );
 
+BOOLEAN
+EqosRxPending (
+  IN EQOS_PRIVATE_DATA  *Eqos
+  );
+
 EFI_STATUS
 EqosStart (
   IN EQOS_PRIVATE_DATA  *Eqos
@@ -191,6 +249,16 @@ EqosDmaMapAllRxDescriptors (
   IN EQOS_PRIVATE_DATA  *Eqos
   );
 
+EFI_STATUS
+EqosDmaRefillRxDescriptors (
+  IN EQOS_PRIVATE_DATA  *Eqos
+  );
+
+UINT32
+EqosReclaimTxDescriptors (
+  IN EQOS_PRIVATE_DATA  *Eqos
+  );
+
 VOID
 EqosDmaUnmapAllTxDescriptors (
   IN EQOS_PRIVATE_DATA  *Eqos
@@ -209,9 +277,15 @@ EqosCheckTxDescriptor (
 
 EFI_STATUS
 EqosCheckRxDescriptor (
-  IN  EQOS_PRIVATE_DATA  *Eqos,
-  IN  UINT32             DescIndex,
-  OUT UINTN              *FrameLength
+  IN  EQOS_PRIVATE_DATA        *Eqos,
+  IN  UINT32                   DescIndex,
+  OUT UINTN                    *FrameLength,
+  OUT EQOS_RX_CHECKSUM_STATUS  *ChecksumStatus  OPTIONAL
+  );
+
+VOID
+EqosResetStatistics (
+  IN EQOS_PRIVATE_DATA  *Eqos
   );
 
 VOID
@@ -16,6 +16,7 @@
 #define BITS(hi, lo)            ((~((~0) << ((hi) + 1))) & ((~0) << (lo)))
 
 #define GMAC_MAC_CONFIGURATION                      0x0000
+#define GMAC_MAC_CONFIGURATION_IPC                  (1U << 27)
 #define GMAC_MAC_CONFIGURATION_CST                  (1U << 21)
 #define GMAC_MAC_CONFIGURATION_ACS                  (1U << 20)
 #define GMAC_MAC_CONFIGURATION_BE                   (1U << 18)
@@ -81,6 +82,8 @@
 #define GMAC_MAC_VERSION_SNPSVER_MASK               0xFFU
 #define GMAC_MAC_DEBUG                              0x0114
 #define GMAC_MAC_HW_FEATURE_BASE                    0x011C
+#define GMAC_MAC_HW_FEATURE0_RXCOESEL               (1U << 16)
+#define GMAC_MAC_HW_FEATURE0_TXCOESEL               (1U << 14)
 #define GMAC_MAC_HW_FEATURE1_TXFIFOSIZE             BITS(10,6)
 #define GMAC_MAC_HW_FEATURE1_RXFIFOSIZE             BITS(4,0)
 #define GMAC_MAC_HW_FEATURE1_ADDR64_SHIFT           14
@@ -206,6 +209,7 @@
 #define GMAC_MTL_RXQ0_OPERATION_MODE_RFD            BITS(19,14)
 #define GMAC_MTL_RXQ0_OPERATION_MODE_RFA            BITS(13,8)
 #define GMAC_MTL_RXQ0_OPERATION_MODE_EHFC           (1U << 7)
+#define GMAC_MTL_RXQ0_OPERATION_MODE_DIS_TCP_EF     (1U << 6)
 #define GMAC_MTL_RXQ0_OPERATION_MODE_RSF            (1U << 5)
 #define GMAC_MTL_RXQ0_OPERATION_MODE_FEP            (1U << 4)
 #define GMAC_MTL_RXQ0_OPERATION_MODE_FUP            (1U << 3)
@@ -257,6 +261,10 @@
 #define GMAC_DMA_CHAN0_RX_RING_LEN                  0x1130
 #define GMAC_DMA_CHAN0_INTR_ENABLE                  0x1134
 #define GMAC_DMA_CHAN0_RX_WATCHDOG                  0x1138
+#define GMAC_DMA_CHAN0_RX_WATCHDOG_RWTU_SHIFT       16
+#define GMAC_DMA_CHAN0_RX_WATCHDOG_RWTU_MASK        (0x3U << GMAC_DMA_CHAN0_RX_WATCHDOG_RWTU_SHIFT)
+#define GMAC_DMA_CHAN0_RX_WATCHDOG_RWTU_256         (0U << GMAC_DMA_CHAN0_RX_WATCHDOG_RWTU_SHIFT)
+#define GMAC_DMA_CHAN0_RX_WATCHDOG_RWT_MASK         0xFFU
 #define GMAC_DMA_CHAN0_SLOT_CTRL_STATUS             0x113C
 #define GMAC_DMA_CHAN0_CUR_TX_DESC                  0x1144
 #define GMAC_DMA_CHAN0_CUR_RX_DESC                  0x114C
@@ -289,6 +297,11 @@
 typedef struct EQOS_DMA_DESCRIPTOR {
   UINT32    Tdes0;
   UINT32    Tdes1;
+  #define EQOS_TDES1_RX_IPCE  (1U << 7)                       /* RX (WB) */
+  #define EQOS_TDES1_RX_IPCB  (1U << 6)                       /* RX (WB) */
+  #define EQOS_TDES1_RX_IPV6  (1U << 5)                       /* RX (WB) */
+  #define EQOS_TDES1_RX_IPV4  (1U << 4)                       /* RX (WB) */
+  #define EQOS_TDES1_RX_IPHE  (1U << 3)                       /* RX (WB) */
   UINT32    Tdes2;
   #define EQOS_TDES2_TX_IOC  (1U << 31)                       /* TX */
   #define EQOS_TDES2_RX_DAF  (1U << 17)                       /* RX (WB) */
@@ -298,6 +311,7 @@ typedef struct EQOS_DMA_DESCRIPTOR {
   #define EQOS_TDES3_TX_FD           (1U << 29)               /* TX */
   #define EQOS_TDES3_TX_LD           (1U << 28)               /* TX */
   #define EQOS_TDES3_TX_DE           (1U << 23)               /* TX (WB) */
+  #define EQOS_TDES3_TX_CIC_FULL     (3U << 16)               /* TX */
   #define EQOS_TDES3_TX_EUE          (1U << 16)               /* TX (WB) */
   #define EQOS_TDES3_TX_ES           (1U << 15)               /* TX (WB) */
   #define EQOS_TDES3_TX_JT           (1U << 14)               /* TX (WB) */
@@ -316,6 +330,7 @@ typedef struct EQOS_DMA_DESCRIPTOR {
   #define EQOS_TDES3_RX_CTXT         (1U << 30)               /* RX (WB) */
   #define EQOS_TDES3_RX_FD           (1U << 29)               /* RX (WB) */
   #define EQOS_TDES3_RX_LD           (1U << 28)               /* RX (WB) */
+  #define EQOS_TDES3_RX_RS1V         (1U << 26)               /* RX (WB) */
   #define EQOS_TDES3_RX_CE           (1U << 24)               /* RX (WB) */
   #define EQOS_TDES3_RX_GP           (1U << 23)               /* RX (WB) */
   #define EQOS_TDES3_RX_RWT          (1U << 22)               /* RX (WB) */
@@ -62,6 +62,9 @@ EqosIdentify (
     Eqos->HwFeatures[3]
     ));
 
+  Eqos->TxChecksumOffload = (Eqos->HwFeatures[0] & GMAC_MAC_HW_FEATURE0_TXCOESEL) != 0;
+  Eqos->RxChecksumOffload = (Eqos->HwFeatures[0] & GMAC_MAC_HW_FEATURE0_RXCOESEL) != 0;
+
   return EFI_SUCCESS;
 }
 
@@ -194,12 +197,18 @@ EqosInitialize (
     GMAC_MTL_TXQ0_OPERATION_MODE_TSF |
     GMAC_MTL_TXQ0_OPERATION_MODE_TXQEN_EN
     );
-  MmioWrite32 (
-    Eqos->Base + GMAC_MTL_RXQ0_OPERATION_MODE,
-    GMAC_MTL_RXQ0_OPERATION_MODE_RSF |
-    GMAC_MTL_RXQ0_OPERATION_MODE_FEP |
-    GMAC_MTL_RXQ0_OPERATION_MODE_FUP
-    );
+  Value = GMAC_MTL_RXQ0_OPERATION_MODE_RSF |
+          GMAC_MTL_RXQ0_OPERATION_MODE_FEP |
+          GMAC_MTL_RXQ0_OPERATION_MODE_FUP;
+  if (Eqos->RxChecksumOffload) {
+    //
+    // Don't let the MTL drop frames that fail the checksum check, so that
+    // they reach the RX path and are counted in RxChecksumErrorFrames.
+    //
+    Value |= GMAC_MTL_RXQ0_OPERATION_MODE_DIS_TCP_EF;
+  }
+
+  MmioWrite32 (Eqos->Base + GMAC_MTL_RXQ0_OPERATION_MODE, Value);
 
   //
   // TX/RX fifo size in hw_feature[1] are log2(n/128), and
@@ -246,6 +255,10 @@ EqosInitialize (
   Value  = MmioRead32 (Eqos->Base + GMAC_MAC_CONFIGURATION);
   Value |= GMAC_MAC_CONFIGURATION_BE;
   Value |= GMAC_MAC_CONFIGURATION_DCRS;
+  if (Eqos->RxChecksumOffload) {
+    Value |= GMAC_MAC_CONFIGURATION_IPC;
+  }
+
   MmioWrite32 (Eqos->Base + GMAC_MAC_CONFIGURATION, Value);
 
   EqosSetMacAddress (Eqos->Base, &Eqos->SnpMode.CurrentAddress);
@@ -364,6 +377,24 @@ EqosDmaInitDescriptorRings (
   IN EQOS_PRIVATE_DATA  *Eqos
   )
 {
+  UINT32  Rwt;
+
+  //
+  // Frames still queued when the rings are reset are never sent. Keep their
+  // buffers for GetStatus(), next to the ones that were already reclaimed.
+  //
+  while ((Eqos->TxQueued > 0) && (Eqos->TxRecycledCount < EQOS_TX_DESC_COUNT)) {
+    EqosDmaUnmapTxDescriptor (Eqos, Eqos->TxCurrent);
+    Eqos->TxRecycled[Eqos->TxRecycledCount++] = Eqos->TxBuffers[Eqos->TxCurrent];
+    Eqos->TxCurrent                           = EQOS_TX_NEXT (Eqos->TxCurrent);
+    Eqos->TxQueued--;
+    Eqos->Stats.TxDroppedFrames++;
+  }
+
+  if (Eqos->TxQueued > 0) {
+    DEBUG ((DEBUG_WARN, "%a: Dropping %u unreturned TX buffers\n", __func__, Eqos->TxQueued));
+  }
+
   Eqos->TxQueued  = 0;
   Eqos->TxNext    = 0;
   Eqos->TxCurrent = 0;
@@ -371,10 +402,46 @@ EqosDmaInitDescriptorRings (
   MmioWrite32 (Eqos->Base + GMAC_DMA_CHAN0_TX_BASE_ADDR, (UINT32)(Eqos->TxDescsPhysAddr));
   MmioWrite32 (Eqos->Base + GMAC_DMA_CHAN0_TX_RING_LEN, EQOS_TX_DESC_COUNT - 1);
 
-  Eqos->RxCurrent = 0;
+  Eqos->RxCurrent    = 0;
+  Eqos->RxDirty      = 0;
+  Eqos->RxDirtyCount = 0;
   MmioWrite32 (Eqos->Base + GMAC_DMA_CHAN0_RX_BASE_ADDR_HI, (UINT32)(Eqos->RxDescsPhysAddr >> 32));
   MmioWrite32 (Eqos->Base + GMAC_DMA_CHAN0_RX_BASE_ADDR, (UINT32)Eqos->RxDescsPhysAddr);
   MmioWrite32 (Eqos->Base + GMAC_DMA_CHAN0_RX_RING_LEN, EQOS_RX_DESC_COUNT - 1);
+
+  //
+  // Coalesce RX completion interrupts.
+  //
+  Rwt = (EQOS_RX_WATCHDOG_USEC * (Eqos->Config.CsrClockRate / 1000000)) / 256;
+  Rwt = MIN (MAX (Rwt, 1), GMAC_DMA_CHAN0_RX_WATCHDOG_RWT_MASK);
+  MmioWrite32 (
+    Eqos->Base + GMAC_DMA_CHAN0_RX_WATCHDOG,
+    GMAC_DMA_CHAN0_RX_WATCHDOG_RWTU_256 | Rwt
+    );
+
+  //
+  // All RX descriptors have been pre-posted, hand the whole ring to the DMA.
+  //
+  MmioWrite32 (
+    Eqos->Base + GMAC_DMA_CHAN0_RX_END_ADDR,
+    (UINT32)(UINTN)EQOS_DESC (Eqos->RxDescs, EQOS_RX_DESC_COUNT - 1)
+    );
+}
+
+BOOLEAN
+EqosRxPending (
+  IN EQOS_PRIVATE_DATA  *Eqos
+  )
+{
+  EQOS_DMA_DESCRIPTOR  *Descriptor;
+
+  if (Eqos->RxDescs == NULL) {
+    return FALSE;
+  }
+
+  Descriptor = EQOS_DESC (Eqos->RxDescs, Eqos->RxCurrent);
+
+  return (Descriptor->Tdes3 & EQOS_TDES3_RX_OWN) == 0;
 }
 
 EFI_STATUS
@@ -556,6 +623,7 @@ EqosDmaMapTxDescriptor (
   EFI_STATUS            Status;
   EFI_PHYSICAL_ADDRESS  BufferPhysAddr;
   EQOS_DMA_DESCRIPTOR   *Descriptor;
+  UINT32                Tdes3;
 
   ASSERT (Eqos->TxBuffersMap[DescIndex] == NULL);
   ASSERT (Eqos->TxBuffers[DescIndex] != NULL);
@@ -577,8 +645,21 @@ EqosDmaMapTxDescriptor (
   Descriptor->Tdes0 = (UINT32)(BufferPhysAddr);
   Descriptor->Tdes1 = (UINT32)(BufferPhysAddr >> 32);
   Descriptor->Tdes2 = EQOS_TDES2_TX_IOC | NumberOfBytes;
+
+  Tdes3 = EQOS_TDES3_TX_OWN | EQOS_TDES3_TX_FD | EQOS_TDES3_TX_LD | NumberOfBytes;
+
+  //
+  // Have the MAC insert the IP header and TCP/UDP/ICMP checksums
+  // (including the pseudo-header). Non-IP frames are left untouched.
+  // The UEFI network stack always fills in the checksums itself, so this
+  // saves no CPU time, it only makes the MAC recompute them.
+  //
+  if (Eqos->TxChecksumOffload) {
+    Tdes3 |= EQOS_TDES3_TX_CIC_FULL;
+  }
+
   MemoryFence ();
-  Descriptor->Tdes3 = EQOS_TDES3_TX_OWN | EQOS_TDES3_TX_FD | EQOS_TDES3_TX_LD | NumberOfBytes;
+  Descriptor->Tdes3 = Tdes3;
 
   MmioWrite32 (Eqos->Base + GMAC_DMA_CHAN0_TX_END_ADDR, (UINT32)(UINTN)Descriptor);
 
@@ -619,13 +700,53 @@ EqosDmaMapRxDescriptor (
   Descriptor->Tdes1 = (UINT32)(BufferPhysAddr >> 32);
   Descriptor->Tdes2 = 0;
   MemoryFence ();
-  Descriptor->Tdes3 = EQOS_TDES3_RX_OWN | EQOS_TDES3_RX_IOC | EQOS_TDES3_RX_BUF1V;
-
-  MmioWrite32 (Eqos->Base + GMAC_DMA_CHAN0_RX_END_ADDR, (UINT32)(UINTN)Descriptor);
+  Descriptor->Tdes3 = EQOS_TDES3_RX_OWN | EQOS_TDES3_RX_BUF1V;
 
   return EFI_SUCCESS;
 }
 
+EFI_STATUS
+EqosDmaRefillRxDescriptors (
+  IN EQOS_PRIVATE_DATA  *Eqos
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      DescIndex;
+  UINT32      LastIndex;
+
+  if (Eqos->RxDirtyCount == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Status    = EFI_SUCCESS;
+  LastIndex = EQOS_RX_DESC_COUNT;
+
+  while (Eqos->RxDirtyCount > 0) {
+    DescIndex = Eqos->RxDirty;
+
+    Status = EqosDmaMapRxDescriptor (Eqos, DescIndex);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    LastIndex          = DescIndex;
+    Eqos->RxDirty      = EQOS_RX_NEXT (DescIndex);
+    Eqos->RxDirtyCount--;
+  }
+
+  //
+  // Advance the tail pointer once for the whole batch.
+  //
+  if (LastIndex < EQOS_RX_DESC_COUNT) {
+    MmioWrite32 (
+      Eqos->Base + GMAC_DMA_CHAN0_RX_END_ADDR,
+      (UINT32)(UINTN)EQOS_DESC (Eqos->RxDescs, LastIndex)
+      );
+  }
+
+  return Status;
+}
+
 VOID
 EqosDmaUnmapTxDescriptor (
   IN  EQOS_PRIVATE_DATA  *Eqos,
@@ -765,32 +886,101 @@ EqosCheckTxDescriptor (
   return EFI_SUCCESS;
 }
 
+UINT32
+EqosReclaimTxDescriptors (
+  IN EQOS_PRIVATE_DATA  *Eqos
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      DescIndex;
+  UINT32      Reclaimed;
+
+  Reclaimed = 0;
+
+  //
+  // Stop early if the recycled buffer array is full, the remaining
+  // descriptors will be picked up once the caller collects some buffers.
+  //
+  while ((Eqos->TxQueued > 0) && (Eqos->TxRecycledCount < EQOS_TX_DESC_COUNT)) {
+    DescIndex = Eqos->TxCurrent;
+
+    Status = EqosCheckTxDescriptor (Eqos, DescIndex);
+    if (Status == EFI_NOT_READY) {
+      break;
+    }
+
+    if (EFI_ERROR (Status)) {
+      Eqos->Stats.TxErrorFrames++;
+    } else {
+      Eqos->Stats.TxGoodFrames++;
+    }
+
+    ASSERT (Eqos->TxBuffersMap[DescIndex] != NULL);
+    EqosDmaUnmapTxDescriptor (Eqos, DescIndex);
+
+    Eqos->TxRecycled[Eqos->TxRecycledCount++] = Eqos->TxBuffers[DescIndex];
+
+    Eqos->TxCurrent = EQOS_TX_NEXT (DescIndex);
+    Eqos->TxQueued--;
+    Reclaimed++;
+  }
+
+  return Reclaimed;
+}
+
 EFI_STATUS
 EqosCheckRxDescriptor (
-  IN  EQOS_PRIVATE_DATA  *Eqos,
-  IN  UINT32             DescIndex,
-  OUT UINTN              *FrameLength
+  IN  EQOS_PRIVATE_DATA        *Eqos,
+  IN  UINT32                   DescIndex,
+  OUT UINTN                    *FrameLength,
+  OUT EQOS_RX_CHECKSUM_STATUS  *ChecksumStatus  OPTIONAL
   )
 {
   EQOS_DMA_DESCRIPTOR  *Descriptor;
+  UINT32               Tdes1;
   UINT32               Tdes2;
   UINT32               Tdes3;
 
   Descriptor = EQOS_DESC (Eqos->RxDescs, DescIndex);
-  Tdes2      = Descriptor->Tdes2;
   Tdes3      = Descriptor->Tdes3;
 
   if (Tdes3 & EQOS_TDES3_RX_OWN) {
     return EFI_NOT_READY;
   }
 
+  //
+  // Don't read the rest of the write-back until we know the
+  // descriptor has been released by the DMA.
+  //
+  MemoryFence ();
+  Tdes1 = Descriptor->Tdes1;
+  Tdes2 = Descriptor->Tdes2;
+
+  if (ChecksumStatus != NULL) {
+    *ChecksumStatus = EqosRxChecksumNotChecked;
+
+    if (Eqos->RxChecksumOffload &&
+        ((Tdes3 & EQOS_TDES3_RX_RS1V) != 0) &&
+        ((Tdes1 & (EQOS_TDES1_RX_IPV4 | EQOS_TDES1_RX_IPV6)) != 0) &&
+        ((Tdes1 & EQOS_TDES1_RX_IPCB) == 0))
+    {
+      if (Tdes1 & (EQOS_TDES1_RX_IPHE | EQOS_TDES1_RX_IPCE)) {
+        *ChecksumStatus = EqosRxChecksumBad;
+      } else {
+        *ChecksumStatus = EqosRxChecksumGood;
+      }
+    }
+  }
+
   if (Tdes3 & EQOS_TDES3_RX_ES) {
     if (Tdes3 & EQOS_TDES3_RX_CE) {
       DEBUG ((DEBUG_ERROR, "%a: CRC Error\n", __func__));
+      Eqos->Stats.RxCrcErrorFrames++;
     }
 
     if (Tdes3 & EQOS_TDES3_RX_GP) {
       DEBUG ((DEBUG_ERROR, "%a: Giant Packet\n", __func__));
+      Eqos->Stats.RxOversizeFrames++;
     }
 
     if (Tdes3 & EQOS_TDES3_RX_RWT) {
@@ -833,6 +1023,39 @@ EqosCheckRxDescriptor (
   return EFI_SUCCESS;
 }
 
+VOID
+EqosResetStatistics (
+  IN EQOS_PRIVATE_DATA  *Eqos
+  )
+{
+  EFI_NETWORK_STATISTICS  *Stats;
+
+  Stats = &Eqos->Stats;
+
+  //
+  // Counters we don't keep track of are reported as unavailable (all ones).
+  //
+  SetMem (Stats, sizeof (*Stats), 0xFF);
+
+  Stats->RxTotalFrames     = 0;
+  Stats->RxGoodFrames      = 0;
+  Stats->RxOversizeFrames  = 0;
+  Stats->RxDroppedFrames   = 0;
+  Stats->RxUnicastFrames   = 0;
+  Stats->RxBroadcastFrames = 0;
+  Stats->RxMulticastFrames = 0;
+  Stats->RxCrcErrorFrames  = 0;
+  Stats->RxTotalBytes      = 0;
+  Stats->TxTotalFrames     = 0;
+  Stats->TxGoodFrames      = 0;
+  Stats->TxUnicastFrames   = 0;
+  Stats->TxBroadcastFrames = 0;
+  Stats->TxMulticastFrames = 0;
+  Stats->TxTotalBytes      = 0;
+  Stats->TxErrorFrames     = 0;
+  Stats->TxDroppedFrames   = 0;
+}
+
 VOID
 EqosGetDmaInterruptStatus (
   IN  EQOS_PRIVATE_DATA  *Eqos,
@@ -8,6 +8,38 @@
 
 #include "Eqos.h"
 
+/**
+  Accounts a frame in the unicast/broadcast/multicast counters
+  based on its destination address.
+
+  @param  DestAddr    The destination HW MAC address of the frame.
+  @param  Unicast     Unicast frames counter.
+  @param  Broadcast   Broadcast frames counter.
+  @param  Multicast   Multicast frames counter.
+
+**/
+STATIC
+VOID
+EqosCountFrameType (
+  IN     UINT8   *DestAddr,
+  IN OUT UINT64  *Unicast,
+  IN OUT UINT64  *Broadcast,
+  IN OUT UINT64  *Multicast
+  )
+{
+  STATIC CONST UINT8  BroadcastAddr[NET_ETHER_ADDR_LEN] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+  };
+
+  if (CompareMem (DestAddr, BroadcastAddr, NET_ETHER_ADDR_LEN) == 0) {
+    (*Broadcast)++;
+  } else if (DestAddr[0] & BIT0) {
+    (*Multicast)++;
+  } else {
+    (*Unicast)++;
+  }
+}
+
 /**
   Changes the state of a network interface from "stopped" to "started".
 
@@ -428,7 +460,52 @@ EqosSnpStatistics (
   OUT EFI_NETWORK_STATISTICS       *StatisticsTable OPTIONAL
   )
 {
-  return EFI_UNSUPPORTED;
+  EQOS_PRIVATE_DATA  *Eqos;
+  EFI_STATUS         Status;
+
+  if (This == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // A NULL StatisticsTable with a valid StatisticsSize is a size query.
+  //
+  if (!Reset && (StatisticsSize == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Eqos = EQOS_PRIVATE_DATA_FROM_SNP_THIS (This);
+  if (Eqos->SnpMode.State == EfiSimpleNetworkStopped) {
+    return EFI_NOT_STARTED;
+  }
+
+  if (Eqos->SnpMode.State != EfiSimpleNetworkInitialized) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Status = EFI_SUCCESS;
+
+  if (StatisticsSize != NULL) {
+    if ((*StatisticsSize < sizeof (EFI_NETWORK_STATISTICS)) || (StatisticsTable == NULL)) {
+      Status = EFI_BUFFER_TOO_SMALL;
+    }
+
+    if (StatisticsTable != NULL) {
+      CopyMem (
+        StatisticsTable,
+        &Eqos->Stats,
+        MIN (*StatisticsSize, sizeof (EFI_NETWORK_STATISTICS))
+        );
+    }
+
+    *StatisticsSize = sizeof (EFI_NETWORK_STATISTICS);
+  }
+
+  if (Reset) {
+    EqosResetStatistics (Eqos);
+  }
+
+  return Status;
 }
 
 /**
@@ -586,7 +663,6 @@ EqosSnpGetStatus (
 {
   EQOS_PRIVATE_DATA  *Eqos;
   EFI_STATUS         Status;
-  UINT32             DescIndex;
 
   if (This == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -606,20 +682,25 @@ EqosSnpGetStatus (
   if (TxBuf != NULL) {
     *TxBuf = NULL;
 
-    if (Eqos->TxQueued > 0) {
-      DescIndex = Eqos->TxCurrent;
-
-      Status = EqosCheckTxDescriptor (Eqos, DescIndex);
-      if (Status != EFI_NOT_READY) {
-        ASSERT (Eqos->TxBuffersMap[DescIndex] != NULL);
-        EqosDmaUnmapTxDescriptor (Eqos, DescIndex);
+    Status = EfiAcquireLockOrFail (&Eqos->Lock);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a: Failed to get lock. Status=%r\n", __func__, Status));
+      return EFI_ACCESS_DENIED;
+    }
 
-        *TxBuf = Eqos->TxBuffers[DescIndex];
+    //
+    // Reclaim everything the DMA has released in one go and hand the
+    // cached buffers back one at a time, as required by the SNP contract.
+    //
+    if (Eqos->TxRecycledCount == 0) {
+      EqosReclaimTxDescriptors (Eqos);
+    }
 
-        Eqos->TxCurrent = EQOS_TX_NEXT (DescIndex);
-        Eqos->TxQueued--;
-      }
+    if (Eqos->TxRecycledCount > 0) {
+      *TxBuf = Eqos->TxRecycled[--Eqos->TxRecycledCount];
     }
+
+    EfiReleaseLock (&Eqos->Lock);
   }
 
   //
@@ -724,7 +805,16 @@ EqosSnpTransmit (
     return EFI_ACCESS_DENIED;
   }
 
+  //
+  // Descriptors released by the DMA can be reused straight away, even if
+  // their buffers have not been collected through GetStatus() yet.
+  //
+  if (Eqos->TxQueued == EQOS_TX_DESC_COUNT - 1) {
+    EqosReclaimTxDescriptors (Eqos);
+  }
+
   if (Eqos->TxQueued == EQOS_TX_DESC_COUNT - 1) {
+    Eqos->TxRingFullStalls++;
     Status = EFI_NOT_READY;
     goto Exit;
   }
@@ -749,6 +839,16 @@ EqosSnpTransmit (
 
   Eqos->TxNext = EQOS_TX_NEXT (DescIndex);
   Eqos->TxQueued++;
+  Eqos->TxQueuedMax = MAX (Eqos->TxQueuedMax, Eqos->TxQueued);
+
+  Eqos->Stats.TxTotalFrames++;
+  Eqos->Stats.TxTotalBytes += BufferSize;
+  EqosCountFrameType (
+    &Frame[0],
+    &Eqos->Stats.TxUnicastFrames,
+    &Eqos->Stats.TxBroadcastFrames,
+    &Eqos->Stats.TxMulticastFrames
+    );
 
   Status = EFI_SUCCESS;
 
@@ -801,12 +901,13 @@ EqosSnpReceive (
   OUT    UINT16                       *Protocol    OPTIONAL
   )
 {
-  EQOS_PRIVATE_DATA  *Eqos;
-  EFI_STATUS         Status;
-  EFI_STATUS         MapStatus;
-  UINT32             DescIndex;
-  UINT8              *Frame;
-  UINTN              FrameLength;
+  EQOS_PRIVATE_DATA        *Eqos;
+  EFI_STATUS               Status;
+  EFI_STATUS               MapStatus;
+  UINT32                   DescIndex;
+  UINT8                    *Frame;
+  UINTN                    FrameLength;
+  EQOS_RX_CHECKSUM_STATUS  ChecksumStatus;
 
   if ((This == NULL) || (Buffer == NULL)) {
     return EFI_INVALID_PARAMETER;
@@ -827,13 +928,35 @@ EqosSnpReceive (
     return EFI_ACCESS_DENIED;
   }
 
+  //
+  // Re-arm the consumed descriptors once a full batch has accumulated, so
+  // that the DMA never runs out of buffers during bursts.
+  //
+  if (Eqos->RxDirtyCount >= EQOS_RX_REFILL_THRESHOLD) {
+    Status = EqosDmaRefillRxDescriptors (Eqos);
+    if (EFI_ERROR (Status)) {
+      goto Exit;
+    }
+  }
+
   DescIndex   = Eqos->RxCurrent;
   FrameLength = 0;
 
-  Status = EqosCheckRxDescriptor (Eqos, DescIndex, &FrameLength);
+  Status = EqosCheckRxDescriptor (Eqos, DescIndex, &FrameLength, &ChecksumStatus);
   if (Status == EFI_NOT_READY) {
+    //
+    // Nothing pending, use this chance to return any partial batch.
+    //
+    MapStatus = EqosDmaRefillRxDescriptors (Eqos);
+    if (EFI_ERROR (MapStatus)) {
+      Status = MapStatus;
+    }
+
     goto Exit;
   } else if (EFI_ERROR (Status)) {
+    Eqos->Stats.RxTotalFrames++;
+    Eqos->Stats.RxDroppedFrames++;
+
     ASSERT (Eqos->RxBuffersMap[DescIndex] != NULL);
     EqosDmaUnmapRxDescriptor (Eqos, DescIndex);
     goto ReleaseDesc;
@@ -876,22 +999,66 @@ EqosSnpReceive (
   CopyMem (Buffer, Frame, FrameLength);
   *BufferSize = FrameLength;
 
-  Status = EFI_SUCCESS;
+  Eqos->Stats.RxTotalFrames++;
+  Eqos->Stats.RxGoodFrames++;
+  Eqos->Stats.RxTotalBytes += FrameLength;
 
-ReleaseDesc:
-  MapStatus = EqosDmaMapRxDescriptor (Eqos, DescIndex);
-  if (EFI_ERROR (MapStatus)) {
-    Status = MapStatus;
-    goto Exit;
+  //
+  // The upper layers have no way of consuming the hardware checksum
+  // verification result, so only account for it.
+  //
+  if (ChecksumStatus == EqosRxChecksumGood) {
+    Eqos->RxChecksumGoodFrames++;
+  } else if (ChecksumStatus == EqosRxChecksumBad) {
+    Eqos->RxChecksumErrorFrames++;
   }
 
-  Eqos->RxCurrent = EQOS_RX_NEXT (Eqos->RxCurrent);
+  EqosCountFrameType (
+    &Frame[0],
+    &Eqos->Stats.RxUnicastFrames,
+    &Eqos->Stats.RxBroadcastFrames,
+    &Eqos->Stats.RxMulticastFrames
+    );
+
+  Status = EFI_SUCCESS;
+
+ReleaseDesc:
+  Eqos->RxCurrent = EQOS_RX_NEXT (DescIndex);
+  Eqos->RxDirtyCount++;
 
 Exit:
   EfiReleaseLock (&Eqos->Lock);
   return Status;
 }
 
+/**
+  Notification function for the WaitForPacket event, signals it
+  whenever a frame is waiting in the receive ring.
+
+  @param  Event      The WaitForPacket event.
+  @param  Context    The driver private data.
+
+**/
+VOID
+EFIAPI
+EqosSnpWaitForPacketNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EQOS_PRIVATE_DATA  *Eqos;
+
+  Eqos = (EQOS_PRIVATE_DATA *)Context;
+
+  if (Eqos->SnpMode.State != EfiSimpleNetworkInitialized) {
+    return;
+  }
+
+  if (EqosRxPending (Eqos)) {
+    gBS->SignalEvent (Event);
+  }
+}
+
 ///
 /// Simple Network Protocol
 ///
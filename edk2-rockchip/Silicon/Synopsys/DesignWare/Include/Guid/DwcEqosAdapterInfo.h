@@ -0,0 +1,51 @@
+/** @file
+  Synopsys DesignWare Ethernet Quality-of-Service (EQoS) Adapter Information
+  types exposed by DwcEqosSnpDxe.
+
+  Copyright (c) 2025, Mario Bălănică <mariobalanica02@gmail.com>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef DWC_EQOS_ADAPTER_INFO_H_
+#define DWC_EQOS_ADAPTER_INFO_H_
+
+#define DWC_EQOS_ADAPTER_INFO_RING_STATE_GUID \
+  { 0x2d1b6f4e, 0x93a7, 0x4c58, { 0xb1, 0x0e, 0x6a, 0x4f, 0xd2, 0x87, 0x35, 0xc9 } }
+
+#define DWC_EQOS_ADAPTER_INFO_OFFLOAD_STATE_GUID \
+  { 0x8f3e5a27, 0x1cd4, 0x4b96, { 0xa7, 0x52, 0x0d, 0xe9, 0x6b, 0x31, 0xc8, 0x4f } }
+
+///
+/// Snapshot of the DMA descriptor ring occupancy.
+///
+typedef struct {
+  UINT32    TxRingSize;
+  UINT32    TxQueued;
+  UINT32    TxQueuedMax;
+  UINT32    TxRecyclePending;
+  UINT64    TxRingFullStalls;
+  UINT32    RxRingSize;
+  UINT32    RxPendingRefill;
+} DWC_EQOS_ADAPTER_INFO_RING_STATE;
+
+///
+/// Hardware offload capabilities and RX checksum verification results.
+///
+/// Checksum offload is enabled whenever the MAC supports it. TSO is never
+/// enabled, as SNP never passes down frames larger than the MTU, so
+/// TcpSegmentationOffload is always FALSE.
+///
+typedef struct {
+  BOOLEAN    TxChecksumOffload;
+  BOOLEAN    RxChecksumOffload;
+  BOOLEAN    TcpSegmentationOffload;
+  UINT64     RxChecksumGoodFrames;
+  UINT64     RxChecksumErrorFrames;
+} DWC_EQOS_ADAPTER_INFO_OFFLOAD_STATE;
+
+extern EFI_GUID  gDwcEqosAdapterInfoRingStateGuid;
+extern EFI_GUID  gDwcEqosAdapterInfoOffloadStateGuid;
+
+#endif